@@ -50,6 +50,11 @@ ESP_Signer::~ESP_Signer()
 
 void ESP_Signer::begin(SignerConfig *cfg)
 {
+#if defined(ESP32)
+    // The task uses the client and the config that will be replaced
+    endRefresherTask();
+#endif
+
     authClient.newClient(&authClient.tcpClient);
 
     config = cfg;
@@ -65,10 +70,21 @@ void ESP_Signer::begin(SignerConfig *cfg)
     config->signer.tokens.token_type = token_type_oauth2_access_token;
 
     authClient.begin(config, &mbfs, &mb_ts, &mb_ts_offset);
+
+    // Restore the valid token from the cache file when the device time is already set
+    authClient.loadTokenCache();
+
+    // Restore the TLS session to resume in the first connection
+    authClient.loadTLSSession();
+    authClient.loadDNSCache();
 }
 
 void ESP_Signer::end()
 {
+#if defined(ESP32)
+    endRefresherTask();
+    freeTokenSnapshot();
+#endif
     authClient.end();
 }
 
@@ -91,6 +107,130 @@ bool ESP_Signer::tokenReady()
     return authClient.tokenReady();
 };
 
+bool ESP_Signer::poll(uint32_t budget_us)
+{
+    return authClient.poll(budget_us);
+}
+
+#if defined(ESP32)
+bool ESP_Signer::beginRefresherTask(uint32_t stackSize, UBaseType_t priority, BaseType_t core)
+{
+    if (!config || refresher_task)
+        return false;
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (!token_buf[i])
+            token_buf[i] = MemoryHelper::createBuffer<char *>(&mbfs, ESP_SIGNER_MAX_ACCESS_TOKEN_LENGTH + 1);
+        if (!token_buf[i])
+            return false;
+    }
+
+    __atomic_store_n(&refresher_stop, false, __ATOMIC_RELEASE);
+
+    return xTaskCreatePinnedToCore(refresherTask, "signerRefresherTask", stackSize, this, priority, &refresher_task, core) == pdPASS;
+}
+
+void ESP_Signer::endRefresherTask()
+{
+    if (!refresher_task)
+        return;
+
+    // The task will delete itself after the current step was done
+    __atomic_store_n(&refresher_stop, true, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&refresher_task, __ATOMIC_ACQUIRE))
+        vTaskDelay(ESP_SIGNER_REFRESHER_TASK_INTERVAL / portTICK_PERIOD_MS);
+}
+
+const char *ESP_Signer::tokenSnapshot()
+{
+    int idx = __atomic_load_n(&token_idx, __ATOMIC_ACQUIRE);
+    return idx < 0 ? "" : token_buf[idx];
+}
+
+size_t ESP_Signer::tokenSnapshot(char *buf, size_t size)
+{
+    if (!buf || size == 0)
+        return 0;
+
+    // The copy is kept only when no token was published while copying, the buffer that was read
+    // can be rewritten only after the next token was published (the generation was changed)
+    for (;;)
+    {
+        uint32_t gen = __atomic_load_n(&token_gen, __ATOMIC_ACQUIRE);
+        int idx = __atomic_load_n(&token_idx, __ATOMIC_ACQUIRE);
+        if (idx < 0)
+        {
+            buf[0] = '\0';
+            return 0;
+        }
+
+        size_t len = strnlen(token_buf[idx], ESP_SIGNER_MAX_ACCESS_TOKEN_LENGTH);
+        if (len >= size)
+            len = size - 1;
+        memcpy(buf, token_buf[idx], len);
+        buf[len] = '\0';
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&token_gen, __ATOMIC_RELAXED) == gen)
+            return len;
+    }
+}
+
+uint32_t ESP_Signer::tokenSnapshotGeneration()
+{
+    return __atomic_load_n(&token_gen, __ATOMIC_ACQUIRE);
+}
+
+void ESP_Signer::refresherTask(void *param)
+{
+    ESP_Signer *signer = (ESP_Signer *)param;
+
+    while (!__atomic_load_n(&signer->refresher_stop, __ATOMIC_ACQUIRE))
+    {
+        if (signer->authClient.poll(ESP_SIGNER_REFRESHER_TASK_POLL_BUDGET_US))
+            signer->publishToken();
+
+        vTaskDelay(ESP_SIGNER_REFRESHER_TASK_INTERVAL / portTICK_PERIOD_MS);
+    }
+
+    __atomic_store_n(&signer->refresher_task, (TaskHandle_t)NULL, __ATOMIC_RELEASE);
+    vTaskDelete(NULL);
+}
+
+void ESP_Signer::publishToken()
+{
+    // The token was already published
+    if (token_idx >= 0 && token_expires == config->signer.tokens.expires)
+        return;
+
+    size_t len = config->internal.auth_token.length();
+    if (len == 0 || len > ESP_SIGNER_MAX_ACCESS_TOKEN_LENGTH)
+        return;
+
+    // Write to the inactive buffer and swap, the fence keeps the previous generation change
+    // ahead of the writes for the readers that are still copying this buffer
+    int idx = token_idx == 0 ? 1 : 0;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(token_buf[idx], config->internal.auth_token.c_str(), len);
+    token_buf[idx][len] = '\0';
+    token_expires = config->signer.tokens.expires;
+
+    __atomic_store_n(&token_idx, idx, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&token_gen, 1, __ATOMIC_RELEASE);
+}
+
+void ESP_Signer::freeTokenSnapshot()
+{
+    __atomic_store_n(&token_idx, -1, __ATOMIC_RELEASE);
+    for (int i = 0; i < 2; i++)
+    {
+        MemoryHelper::freeBuffer(&mbfs, token_buf[i]);
+        token_buf[i] = nullptr;
+    }
+}
+#endif
+
 String ESP_Signer::getTokenType(TokenInfo info)
 {
     return authClient.getTokenType(info);
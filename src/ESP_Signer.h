@@ -41,6 +41,7 @@
 
 class ESP_Signer
 {
+    friend class AuthorizedClient;
 
 public:
     ESP_Signer();
@@ -109,6 +110,80 @@ public:
      */
     bool tokenReady();
 
+    /**
+     * Process the token generation, signing, request and refresh in non-blocking mode.
+     *
+     * @param budget_us The time budget in microseconds for this call.
+     * @return Boolean of ready state.
+     *
+     * @note Use this function instead of tokenReady in the time critical loop.
+     * At least one step will be processed in every call and the next steps will be processed while the budget remains.
+     * The SSL handshake is processed with the received data in every call without waiting for the server.
+     * The steps that can't be sliced and can exceed the budget are
+     * the RSA signing, one RSA-2048 private key operation in the order of a second on ESP8266 (see config.signer.preSign),
+     * the DNS lookup and the TCP connection, limited by config.timeout.socketConnection,
+     * and the handshake step that verifies the server certificate chain (see config.cert.pin_ttl).
+     *
+     */
+    bool poll(uint32_t budget_us = 1000);
+
+#if defined(ESP32)
+    /**
+     * Start the FreeRTOS task that processes and refreshes the token in background (ESP32 only).
+     *
+     * @param stackSize The task stack size in bytes.
+     * @param priority The task priority.
+     * @param core The core that the task will be pinned to.
+     * @return Boolean type status indicates the success of the operation.
+     *
+     * @note The task owns the token processing while it is running,
+     * tokenReady, poll, accessToken and refreshToken should not be called, use tokenSnapshot instead.
+     * The task is stopped by begin and end, start it again after begin was called.
+     *
+     */
+    bool beginRefresherTask(uint32_t stackSize = 8192, UBaseType_t priority = 1, BaseType_t core = tskNO_AFFINITY);
+
+    /**
+     * Stop the background refresher task and wait until the task was deleted (ESP32 only).
+     *
+     */
+    void endRefresherTask();
+
+    /**
+     * Get the access token that was published by the background refresher task (ESP32 only).
+     *
+     * @return The pointer to access token or empty string when the token is not ready.
+     *
+     * @note This function is wait-free and copy-free and can be called from any task.
+     * The token is double-buffered, the buffer of the returned pointer will be rewritten when the token
+     * was published again. Read tokenSnapshotGeneration before calling this function and check that it
+     * was not changed after the token was used, otherwise get the token again, or use tokenSnapshot(buf, size).
+     *
+     */
+    const char *tokenSnapshot();
+
+    /**
+     * Copy the access token that was published by the background refresher task (ESP32 only).
+     *
+     * @param buf The buffer to copy the null-terminated token to.
+     * @param size The buffer size, ESP_SIGNER_MAX_ACCESS_TOKEN_LENGTH + 1 for the complete token.
+     * @return The length of the copied token or 0 when the token is not ready.
+     *
+     * @note This function can be called from any task, the token is copied again when it was
+     * published while copying.
+     *
+     */
+    size_t tokenSnapshot(char *buf, size_t size);
+
+    /**
+     * Get the number of access tokens that were published by the background refresher task (ESP32 only).
+     *
+     * @return The published token count which can be used to check for the new token.
+     *
+     */
+    uint32_t tokenSnapshotGeneration();
+#endif
+
     /**
      * Get the generated access token.
      *
@@ -283,6 +358,21 @@ protected:
     MB_FS mbfs;
     uint32_t mb_ts = 0;
     uint32_t mb_ts_offset = 0;
+
+#if defined(ESP32)
+    TaskHandle_t refresher_task = NULL;
+    // the refresher and snapshot states are accessed with GCC atomic builtins which keep this class copyable
+    bool refresher_stop = false;
+    char *token_buf[2] = {nullptr, nullptr};
+    int token_idx = -1;
+    uint32_t token_gen = 0;
+    unsigned long token_expires = 0;
+
+    static void refresherTask(void *param);
+    void publishToken();
+    void freeTokenSnapshot();
+#endif
+
     void mSetClient(Client *client, ESP_Signer_NetworkConnectionRequestCallback networkConnectionCB,
                     ESP_Signer_NetworkStatusRequestCallback networkStatusCB);
 };
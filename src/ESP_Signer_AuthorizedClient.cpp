@@ -0,0 +1,458 @@
+/**
+ * Google APIs authorized HTTP client, ESP_Signer_AuthorizedClient.cpp version 1.0.0
+ *
+ * This library supports ESP8266, ESP32 and Raspberry Pi Pico.
+ *
+ * Created October 16, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ESP_SIGNER_AUTHORIZED_CLIENT_CPP
+#define ESP_SIGNER_AUTHORIZED_CLIENT_CPP
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "ESP_Signer_AuthorizedClient.h"
+
+AuthorizedClient::AuthorizedClient()
+{
+}
+
+AuthorizedClient::~AuthorizedClient()
+{
+}
+
+void AuthorizedClient::begin(ESP_Signer *signer)
+{
+    this->signer = signer;
+}
+
+void AuthorizedClient::setKeepAlive(bool keepAlive)
+{
+    this->keepAlive = keepAlive;
+}
+
+int AuthorizedClient::request(esp_signer_request_method method, const char *host, const char *path,
+                              const char *contentType, const uint8_t *body, size_t bodyLen,
+                              esp_signer_http_body_cb responseCB, void *arg)
+{
+    struct esp_signer_api_request_t req;
+    req.method = method;
+    req.host = host;
+    req.path = path;
+    req.contentType = contentType;
+    req.body = body;
+    req.bodyLen = body ? bodyLen : 0;
+    return sendRequest(req, responseCB, arg);
+}
+
+int AuthorizedClient::request(esp_signer_request_method method, const char *host, const char *path,
+                              const char *contentType, Stream *body, size_t bodyLen,
+                              esp_signer_http_body_cb responseCB, void *arg)
+{
+    struct esp_signer_api_request_t req;
+    req.method = method;
+    req.host = host;
+    req.path = path;
+    req.contentType = contentType;
+    req.stream = body;
+    req.bodyLen = body ? bodyLen : 0;
+    return sendRequest(req, responseCB, arg);
+}
+
+int AuthorizedClient::request(esp_signer_request_method method, const char *host, const char *path,
+                              const char *contentType, const char *body, String &response)
+{
+    response.remove(0);
+    return request(method, host, path, contentType, (const uint8_t *)body, body ? strlen(body) : 0, appendString, &response);
+}
+
+int AuthorizedClient::uploadFile(const char *bucket, const char *object, const char *path, esp_signer_mem_storage_type storageType,
+                                 const char *contentType, size_t chunkSize, esp_signer_upload_progress_cb progressCB, void *arg)
+{
+    if (!signer || !bucket || !object || !path)
+        return ESP_SIGNER_ERROR_TOKEN_NOT_READY;
+
+    int total = signer->mbfs.open(path, mbfs_type storageType, mb_fs_open_mode_read);
+    if (total < 0)
+        return total;
+    signer->mbfs.close(mbfs_type storageType);
+
+    if (!contentType)
+        contentType = esp_signer_gcs_pgm_str_9; // "application/octet-stream"
+
+    // Only the last chunk can be smaller than 256 KiB
+    if (chunkSize < ESP_SIGNER_UPLOAD_CHUNK_UNIT)
+        chunkSize = ESP_SIGNER_UPLOAD_CHUNK_UNIT;
+    chunkSize -= chunkSize % (ESP_SIGNER_UPLOAD_CHUNK_UNIT);
+
+    MB_String location;
+    int code = beginUpload(bucket, object, contentType, total, location);
+    if (code != ESP_SIGNER_ERROR_HTTP_CODE_OK)
+        return code;
+
+    // The session URI e.g. https://storage.googleapis.com/upload/storage/v1/b/<bucket>/o?uploadType=resumable&upload_id=<id>
+    int hostPos = StringHelper::strpos(location.c_str(), pgm2Str(esp_signer_pgm_str_32 /* "https://" */), 0);
+    hostPos = hostPos < 0 ? 0 : hostPos + strlen_P(esp_signer_pgm_str_32);
+    int pathPos = StringHelper::strpos(location.c_str(), pgm2Str(esp_signer_pgm_str_31 /* "/" */), hostPos);
+    if (pathPos < 0)
+        return ESP_SIGNER_ERROR_TCP_RESPONSE_READ_FAILED;
+
+    MB_String host, uploadPath;
+    location.substr(host, hostPos, pathPos - hostPos);
+    location.substr(uploadPath, pathPos, location.length() - pathPos);
+    location.clear();
+
+    this->progressCB = progressCB;
+    this->progressArg = arg;
+    uploadTotal = total;
+
+    size_t committed = 0;
+    int retry = 0;
+
+    while (true)
+    {
+        size_t len = total - committed, last = committed;
+        if (len > chunkSize)
+            len = chunkSize;
+
+        code = sendUploadChunk(host.c_str(), uploadPath.c_str(), path, storageType, committed, len, total, committed);
+
+        // 308 (Resume Incomplete), continue from the committed offset
+        if (code == ESP_SIGNER_ERROR_HTTP_CODE_PERMANENT_REDIRECT)
+        {
+            if (committed > last)
+                retry = 0;
+            else if (++retry > ESP_SIGNER_UPLOAD_MAX_RETRY)
+                break;
+        }
+        else if (code == ESP_SIGNER_ERROR_HTTP_CODE_OK || code == ESP_SIGNER_ERROR_HTTP_CODE_CREATED)
+            break;
+        else if ((code < 0 || code >= ESP_SIGNER_ERROR_HTTP_CODE_INTERNAL_SERVER_ERROR) && ++retry <= ESP_SIGNER_UPLOAD_MAX_RETRY)
+        {
+            // The connection was lost or the server error, query the committed offset to resume the upload
+            code = sendUploadChunk(host.c_str(), uploadPath.c_str(), path, storageType, committed, 0, total, committed);
+            if (code == ESP_SIGNER_ERROR_HTTP_CODE_OK || code == ESP_SIGNER_ERROR_HTTP_CODE_CREATED)
+                break;
+        }
+        else
+            break;
+    }
+
+    if (progressCB && (code == ESP_SIGNER_ERROR_HTTP_CODE_OK || code == ESP_SIGNER_ERROR_HTTP_CODE_CREATED))
+        progressCB(arg, total, total);
+
+    this->progressCB = nullptr;
+    return code;
+}
+
+int AuthorizedClient::beginUpload(const char *bucket, const char *object, const char *contentType, size_t total, MB_String &location)
+{
+    // /upload/storage/v1/b/<bucket>/o?uploadType=resumable&name=<url encoded object name>
+    MB_String path = esp_signer_gcs_pgm_str_2;
+    path += bucket;
+    path += esp_signer_gcs_pgm_str_3;
+    size_t pos = path.length();
+    path.append(HttpHelper::putUrlEncoded(nullptr, object), ' ');
+    HttpHelper::putUrlEncoded(&path[pos], object);
+
+    MB_String headers = esp_signer_gcs_pgm_str_4; // "X-Upload-Content-Type: "
+    headers += contentType;
+    headers += esp_signer_pgm_str_1;     // "\r\n"
+    headers += esp_signer_gcs_pgm_str_5; // "X-Upload-Content-Length: "
+    headers += total;
+    headers += esp_signer_pgm_str_1; // "\r\n"
+
+    MB_String host = esp_signer_gcs_pgm_str_1; // "storage.googleapis.com"
+
+    struct esp_signer_api_request_t req;
+    req.method = http_post;
+    req.host = host.c_str();
+    req.path = path.c_str();
+    req.headers = headers.c_str();
+    req.captureName = esp_signer_gcs_pgm_str_7; // "Location: "
+    req.captureValue = &location;
+
+    int code = sendRequest(req, nullptr, nullptr);
+
+    if (code == ESP_SIGNER_ERROR_HTTP_CODE_OK && location.length() == 0)
+        code = ESP_SIGNER_ERROR_TCP_RESPONSE_READ_FAILED;
+
+    return code;
+}
+
+int AuthorizedClient::sendUploadChunk(const char *host, const char *path, const char *filePath, esp_signer_mem_storage_type storageType,
+                                      size_t offset, size_t len, size_t total, size_t &committed)
+{
+    // Content-Range: bytes <first>-<last>/<total> or bytes */<total> for the upload status
+    MB_String headers = esp_signer_gcs_pgm_str_6;
+    if (len > 0)
+    {
+        headers += offset;
+        headers += '-';
+        headers += offset + len - 1;
+        headers += esp_signer_pgm_str_31; // "/"
+    }
+    else
+        headers += esp_signer_gcs_pgm_str_10; // "*/"
+    headers += total;
+    headers += esp_signer_pgm_str_1; // "\r\n"
+
+    MB_String range;
+
+    struct esp_signer_api_request_t req;
+    req.method = http_put;
+    req.host = host;
+    req.path = path;
+    req.headers = headers.c_str();
+    req.filePath = filePath;
+    req.storageType = storageType;
+    req.fileOffset = offset;
+    req.bodyLen = len;
+    req.captureName = esp_signer_gcs_pgm_str_8; // "Range: "
+    req.captureValue = &range;
+
+    int code = sendRequest(req, nullptr, nullptr);
+
+    // 308 with Range: bytes=0-<last committed byte>, no Range header when nothing was committed
+    if (code == ESP_SIGNER_ERROR_HTTP_CODE_PERMANENT_REDIRECT)
+    {
+        int pos = StringHelper::strpos(range.c_str(), "-", 0);
+        committed = pos < 0 ? 0 : atoi(range.c_str() + pos + 1) + 1;
+    }
+
+    return code;
+}
+
+int AuthorizedClient::contentLength()
+{
+    return parser.contentLen;
+}
+
+void AuthorizedClient::stop()
+{
+    if (signer && signer->authClient.tcpClient)
+        signer->authClient.tcpClient->stop();
+}
+
+void AuthorizedClient::appendString(void *arg, const char *data, size_t len)
+{
+    ((String *)arg)->concat(data, len);
+}
+
+void AuthorizedClient::responseBody(void *arg, const char *data, size_t len)
+{
+    AuthorizedClient *self = (AuthorizedClient *)arg;
+
+    if (self->discardUnauthorized && self->parser.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_UNAUTHORIZED)
+        return;
+
+    if (self->responseCB)
+        self->responseCB(self->responseArg, data, len);
+}
+
+size_t AuthorizedClient::writeHeader(char *out, const esp_signer_api_request_t &req, const char *token, size_t *tokenOffset)
+{
+    size_t n = HttpHelper::putRequestFirst(out, req.method);
+    n += HttpHelper::putText(out ? out + n : nullptr, req.path);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_16 /* " HTTP/1.1\r\n" */);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_4 /* "Host: " */);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, req.host);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_7 /* "User-Agent: ESP\r\n" */);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_17 /* "Authorization: " */);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_18 /* "Bearer " */);
+    // The token is left out and sent from its own buffer
+    if (tokenOffset)
+        *tokenOffset = n;
+    else
+        n += HttpHelper::putText(out ? out + n : nullptr, token);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+    n += HttpHelper::putConnectionHeader(out ? out + n : nullptr, keepAlive);
+
+    if (req.headers)
+        n += HttpHelper::putText(out ? out + n : nullptr, req.headers);
+
+    if (req.contentType && req.bodyLen > 0)
+        n += HttpHelper::putContentHeaders(out ? out + n : nullptr, req.bodyLen, req.contentType);
+    else
+    {
+        // The body length is required for POST, PUT and PATCH even it is empty
+        if (req.method == http_post || req.method == http_put || req.method == http_patch || req.bodyLen > 0)
+        {
+            n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_6 /* "Content-Length: " */);
+            n += JWTHelper::putInt(out ? out + n : nullptr, req.bodyLen);
+            n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+        }
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+    }
+
+    return n;
+}
+
+bool AuthorizedClient::writeBody(GAuth_TCP_Client *client, const esp_signer_api_request_t &req)
+{
+    if (req.bodyLen == 0)
+        return true;
+
+    if (req.body)
+        return client->write(req.body, req.bodyLen) == req.bodyLen;
+
+    if (req.stream)
+        return writeStream(client, req.stream, req.bodyLen);
+
+    if (req.filePath)
+        return writeFile(client, req);
+
+    return false;
+}
+
+bool AuthorizedClient::writeFile(GAuth_TCP_Client *client, const esp_signer_api_request_t &req)
+{
+    MB_FS *mbfs = &signer->mbfs;
+
+    // The file is opened for every request as the file system is also used by the token cache in between
+    if (mbfs->open(req.filePath, mbfs_type req.storageType, mb_fs_open_mode_read) < 0)
+        return false;
+
+    uint8_t *buf = nullptr;
+    size_t sent = 0;
+
+    if (mbfs->seek(mbfs_type req.storageType, req.fileOffset))
+        buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, ESP_SIGNER_UPLOAD_BLOCK_SIZE);
+
+    while (buf && sent < req.bodyLen)
+    {
+        size_t toRead = req.bodyLen - sent;
+        if (toRead > ESP_SIGNER_UPLOAD_BLOCK_SIZE)
+            toRead = ESP_SIGNER_UPLOAD_BLOCK_SIZE;
+
+        int read = mbfs->read(mbfs_type req.storageType, buf, toRead);
+        if (read <= 0 || client->write(buf, read) != (size_t)read)
+            break;
+
+        sent += read;
+
+        if (progressCB)
+            progressCB(progressArg, req.fileOffset + sent, uploadTotal);
+    }
+
+    MemoryHelper::freeBuffer(mbfs, buf);
+    mbfs->close(mbfs_type req.storageType);
+
+    return sent == req.bodyLen;
+}
+
+int AuthorizedClient::sendRequest(esp_signer_api_request_t &req, esp_signer_http_body_cb responseCB, void *arg)
+{
+    if (!signer || !signer->config || !req.host || !req.path)
+        return ESP_SIGNER_ERROR_TOKEN_NOT_READY;
+
+    GAuth_OAuth2_Client *auth = &signer->authClient;
+
+#if defined(ESP32)
+    // The background refresher task owns the TCP client
+    if (signer->refresher_task)
+        return ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_INUSED;
+#endif
+
+    this->responseCB = responseCB;
+    this->responseArg = arg;
+
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+        // The token request (non-blocking mode) is using the TCP client
+        if (auth->isBusy())
+            return ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_INUSED;
+
+        if (!auth->tokenReady())
+            return ESP_SIGNER_ERROR_TOKEN_NOT_READY;
+
+        GAuth_TCP_Client *client = auth->tcpClient;
+
+        // The connection to other host (e.g. the token server) will be closed and the TLS session will be resumed later
+        auth->response_code = 0;
+        client->begin(req.host, 443, &auth->response_code);
+
+        if (!client->connected())
+            auth->setCert(client);
+
+        const MB_String &token = auth->config->internal.auth_token;
+
+        // The header without the token is written to the exact size buffer, the header, token and the body
+        // in memory are gathered into the TLS records and sent at once
+        size_t tokenOffset = 0;
+        size_t len = writeHeader(nullptr, req, nullptr, &tokenOffset);
+        char *header = MemoryHelper::createBuffer<char *>(&signer->mbfs, len + 1);
+        if (!header)
+            return ESP_SIGNER_ERROR_TCP_ERROR_TOO_LESS_RAM;
+
+        writeHeader(header, req, nullptr, &tokenOffset);
+
+        esp_ssl_client_segment segments[4] = {{header, tokenOffset, false},
+                                              {token.c_str(), token.length(), false},
+                                              {header + tokenOffset, len - tokenOffset, false},
+                                              {req.body, req.body ? req.bodyLen : 0, false}};
+
+        size_t count = req.body && req.bodyLen > 0 ? 4 : 3;
+        size_t total = 0;
+        for (size_t i = 0; i < count; i++)
+            total += segments[i].len;
+
+        int sent = client->writev(segments, count);
+        MemoryHelper::freeBuffer(&signer->mbfs, header);
+
+        // The short write is the send error even the TCP client error was not set
+        if (sent != (int)total)
+            auth->response_code = sent < 0 ? sent : ESP_SIGNER_ERROR_TCP_ERROR_STREAM_WRITE;
+
+        // The body from stream or file is sent after the header
+        if (auth->response_code >= 0 && !req.body && !writeBody(client, req))
+            auth->response_code = ESP_SIGNER_ERROR_TCP_ERROR_STREAM_WRITE;
+
+        if (auth->response_code < 0)
+        {
+            client->stop();
+            return auth->response_code;
+        }
+
+        HttpParser::reset(parser, responseBody, this, req.captureName, req.captureValue);
+
+        // The body from stream can't be sent again
+        discardUnauthorized = attempt == 0 && !req.stream;
+
+        bool complete = auth->handleResponse(client, parser, !keepAlive);
+
+        if (!complete && parser.httpCode == 0)
+            return auth->response_code < 0 ? auth->response_code : ESP_SIGNER_ERROR_TCP_RESPONSE_READ_FAILED;
+
+        if (parser.httpCode != ESP_SIGNER_ERROR_HTTP_CODE_UNAUTHORIZED || !discardUnauthorized)
+            break;
+
+        // The access token was rejected (e.g. revoked), request the new token and send the request again
+        auth->config->signer.tokens.expires = 0;
+    }
+
+    return parser.httpCode;
+}
+
+#endif
@@ -0,0 +1,187 @@
+/**
+ * Google APIs authorized HTTP client, ESP_Signer_AuthorizedClient.h version 1.0.0
+ *
+ * The requests are sent with the access token from the signer through the signer's TCP client and connection.
+ *
+ * This library supports ESP8266, ESP32 and Raspberry Pi Pico.
+ *
+ * Created October 16, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ESP_SIGNER_AUTHORIZED_CLIENT_H
+#define ESP_SIGNER_AUTHORIZED_CLIENT_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "ESP_Signer.h"
+
+class AuthorizedClient
+{
+
+public:
+    AuthorizedClient();
+    ~AuthorizedClient();
+
+    /**
+     * Begin the authorized client.
+     *
+     * @param signer The pointer to ESP_Signer object that provides the access token and its TCP client.
+     *
+     * @note The signer should be begun before the request and existed as long as this client was used.
+     * The token request and the API requests share the same TCP client, one at a time.
+     *
+     */
+    void begin(ESP_Signer *signer);
+
+    /**
+     * Keep the connection after the request (Connection: keep-alive) to reuse in the next request.
+     *
+     * @param keepAlive The keep-alive option, default is true.
+     *
+     */
+    void setKeepAlive(bool keepAlive);
+
+    /**
+     * Send the authorized request and pass the response body to the callback while it is received.
+     *
+     * @param method The HTTP method e.g. http_get, http_post.
+     * @param host The API host name e.g. storage.googleapis.com.
+     * @param path The request path and query e.g. /storage/v1/b/my-bucket/o.
+     * @param contentType The request body content type.
+     * @param body The request body data.
+     * @param bodyLen The request body length.
+     * @param responseCB The response body callback.
+     * @param arg The argument passed to the response body callback.
+     * @return The HTTP status code or the negative error code.
+     *
+     * @note The request will be sent again once with the new access token when the server responded with 401.
+     *
+     */
+    int request(esp_signer_request_method method, const char *host, const char *path,
+                const char *contentType = nullptr, const uint8_t *body = nullptr, size_t bodyLen = 0,
+                esp_signer_http_body_cb responseCB = nullptr, void *arg = nullptr);
+
+    /**
+     * Send the authorized request with the body from stream and pass the response body to the callback.
+     *
+     * @param method The HTTP method e.g. http_put, http_post.
+     * @param host The API host name e.g. storage.googleapis.com.
+     * @param path The request path and query.
+     * @param contentType The request body content type.
+     * @param body The pointer to Stream object e.g. File that provides the request body.
+     * @param bodyLen The number of bytes to read from stream and send.
+     * @param responseCB The response body callback.
+     * @param arg The argument passed to the response body callback.
+     * @return The HTTP status code or the negative error code.
+     *
+     * @note The stream can't be read again, the request will not be sent again when the server responded with 401.
+     *
+     */
+    int request(esp_signer_request_method method, const char *host, const char *path,
+                const char *contentType, Stream *body, size_t bodyLen,
+                esp_signer_http_body_cb responseCB = nullptr, void *arg = nullptr);
+
+    /**
+     * Send the authorized request and get the response body as string.
+     *
+     * @param method The HTTP method.
+     * @param host The API host name.
+     * @param path The request path and query.
+     * @param contentType The request body content type.
+     * @param body The request body string e.g. JSON.
+     * @param response The String to store the response body.
+     * @return The HTTP status code or the negative error code.
+     *
+     */
+    int request(esp_signer_request_method method, const char *host, const char *path,
+                const char *contentType, const char *body, String &response);
+
+    /**
+     * Upload the file to Google Cloud Storage with the resumable upload.
+     *
+     * @param bucket The bucket name.
+     * @param object The object name.
+     * @param path The file path in the file system.
+     * @param storageType The file storage type e.g. esp_signer_mem_storage_type_flash or esp_signer_mem_storage_type_sd.
+     * @param contentType The object content type.
+     * @param chunkSize The upload chunk size which will be rounded down to multiple of 256 KiB.
+     * @param progressCB The upload progress callback.
+     * @param arg The argument passed to the progress callback.
+     * @return The HTTP status code (200 or 201 for success) or the negative error code.
+     *
+     * @note The file is read in blocks and sent while reading, each chunk is a separate request.
+     * When the connection was lost or the server responded with error (5xx), the committed offset is queried
+     * and the upload is resumed from there.
+     *
+     */
+    int uploadFile(const char *bucket, const char *object, const char *path, esp_signer_mem_storage_type storageType,
+                   const char *contentType = nullptr, size_t chunkSize = ESP_SIGNER_UPLOAD_CHUNK_UNIT,
+                   esp_signer_upload_progress_cb progressCB = nullptr, void *arg = nullptr);
+
+    /**
+     * Get the content length of the last response.
+     *
+     * @return The content length or -1 when the response has no Content-Length header.
+     *
+     */
+    int contentLength();
+
+    /**
+     * Close the connection.
+     *
+     */
+    void stop();
+
+protected:
+    ESP_Signer *signer = nullptr;
+    bool keepAlive = true;
+    esp_signer_http_parser_t parser;
+    esp_signer_http_body_cb responseCB = nullptr;
+    void *responseArg = nullptr;
+    /* the unauthorized response body is discarded when the request will be sent again */
+    bool discardUnauthorized = false;
+    /* the upload progress */
+    esp_signer_upload_progress_cb progressCB = nullptr;
+    void *progressArg = nullptr;
+    size_t uploadTotal = 0;
+
+    int sendRequest(esp_signer_api_request_t &req, esp_signer_http_body_cb responseCB, void *arg);
+    /* write the request header or count its length when out is null, the token is left out when tokenOffset is set */
+    size_t writeHeader(char *out, const esp_signer_api_request_t &req, const char *token, size_t *tokenOffset = nullptr);
+    /* send the request body from memory, stream or file */
+    bool writeBody(GAuth_TCP_Client *client, const esp_signer_api_request_t &req);
+    /* read the stream in chunks and send */
+    bool writeStream(GAuth_TCP_Client *client, Stream *stream, size_t len);
+    /* read the file from the offset in blocks and send */
+    bool writeFile(GAuth_TCP_Client *client, const esp_signer_api_request_t &req);
+    /* start the resumable upload session and get the session URI */
+    int beginUpload(const char *bucket, const char *object, const char *contentType, size_t total, MB_String &location);
+    /* send the upload chunk or query the upload status (len is 0), the committed bytes are updated from the Range header */
+    int sendUploadChunk(const char *host, const char *path, const char *filePath, esp_signer_mem_storage_type storageType,
+                        size_t offset, size_t len, size_t total, size_t &committed);
+    static void responseBody(void *arg, const char *data, size_t len);
+    static void appendString(void *arg, const char *data, size_t len);
+};
+
+#endif
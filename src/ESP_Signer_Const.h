@@ -6,6 +6,56 @@
 
 #define ESP_SIGNER_DEFAULT_AUTH_TOKEN_EXPIRED_SECONDS 3600
 
+#define ESP_SIGNER_PRE_SIGN_LEAD_SECONDS 5 * 60
+
+#define ESP_SIGNER_PRE_CONNECT_RETRY_INTERVAL 10 * 1000
+
+// The SignerPool entry that failed (e.g. the invalid credentials) is retried after this interval which is doubled
+// for every next failure up to the max interval
+#define ESP_SIGNER_POOL_RETRY_MIN_INTERVAL 5 * 1000
+#define ESP_SIGNER_POOL_RETRY_MAX_INTERVAL 5 * 60 * 1000
+
+#define ESP_SIGNER_MAX_ACCESS_TOKEN_LENGTH 2048
+
+#define ESP_SIGNER_TOKEN_CACHE_VERSION 1
+// magic (4) + version (1) + flags (1) + payload length (2) + nonce (12)
+#define ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE 20
+#define ESP_SIGNER_TOKEN_CACHE_TAG_SIZE 16
+
+#define ESP_SIGNER_REFRESHER_TASK_INTERVAL 10
+
+// The number of hosts that their TLS session parameters are kept for the session resumption
+#define ESP_SIGNER_TLS_SESSION_CACHE_SIZE 2
+// session id length (1) + session id (32) + version (2) + cipher suite (2) + master secret (48)
+#define ESP_SIGNER_TLS_SESSION_PARAMS_SIZE 85
+// The saved TLS session older than this will not be resumed
+#define ESP_SIGNER_TLS_SESSION_MAX_AGE 24 * 3600
+
+// The number of hosts that their resolved addresses are kept
+#define ESP_SIGNER_DNS_CACHE_SIZE 4
+
+// The HTTP status line and header line bytes that are kept while parsing, the rest is ignored
+#define ESP_SIGNER_HTTP_PARSER_LINE_SIZE 64
+
+// The receive buffer size for reading the HTTP response in bulk
+#define ESP_SIGNER_HTTP_RECEIVE_BUFFER_SIZE 512
+
+// The key name bytes that are kept while scanning the token response, the longest matched key is "error_description"
+#define ESP_SIGNER_TOKEN_RESPONSE_KEY_SIZE 20
+
+// The Google Cloud Storage resumable upload chunk size should be multiple of this except the last chunk
+#define ESP_SIGNER_UPLOAD_CHUNK_UNIT 256 * 1024
+
+// The file read block size in bytes that is passed to the TCP client at once while uploading
+#ifndef ESP_SIGNER_UPLOAD_BLOCK_SIZE
+#define ESP_SIGNER_UPLOAD_BLOCK_SIZE 2048
+#endif
+
+// The number of times that the upload is resumed after the connection was lost or the server error
+#define ESP_SIGNER_UPLOAD_MAX_RETRY 3
+
+#define ESP_SIGNER_REFRESHER_TASK_POLL_BUDGET_US 10 * 1000
+
 #define ESP_SIGNER_DEFAULT_REQUEST_TIMEOUT 2000
 
 #define ESP_SIGNER_DEFAULT_TS 1618971013
@@ -144,6 +194,32 @@ enum esp_signer_gauth_jwt_generation_step
     esp_signer_gauth_jwt_generation_step_exchange
 };
 
+/* The token request states in non-blocking (poll) mode */
+enum esp_signer_gauth_poll_state
+{
+    esp_signer_gauth_poll_state_idle,
+    esp_signer_gauth_poll_state_connect,
+    esp_signer_gauth_poll_state_handshake,
+    esp_signer_gauth_poll_state_send,
+    esp_signer_gauth_poll_state_wait_response,
+    esp_signer_gauth_poll_state_read_response
+};
+
+/* The BearSSL RSA PKCS#1 v1.5 signing implementations */
+enum esp_signer_rsa_sign_backend
+{
+    /* select the fastest implementation for the build target */
+    esp_signer_rsa_sign_backend_auto,
+    /* 15-bit words, for the CPU that has no fast 32x32->64 multiplication e.g. ESP8266 and RP2040 */
+    esp_signer_rsa_sign_backend_i15,
+    /* 31-bit words */
+    esp_signer_rsa_sign_backend_i31,
+    /* 32-bit words */
+    esp_signer_rsa_sign_backend_i32,
+    /* 62-bit words, available only on the 64-bit platform */
+    esp_signer_rsa_sign_backend_i62
+};
+
 enum esp_signer_request_method
 {
     http_undefined,
@@ -214,6 +290,8 @@ struct esp_signer_gauth_auth_token_info_t
     MB_String auth_type;
     MB_String jwt;
     MB_String scope;
+    /* the audience (API endpoint) of self-signed JWT token e.g. https://pubsub.googleapis.com/ */
+    MB_String audience;
     unsigned long expires = 0;
     /* milliseconds count when last expiry time was set */
     unsigned long last_millis = 0;
@@ -237,20 +315,23 @@ struct esp_signer_gauth_token_signer_resources_t
     unsigned long lastReqMillis = 0;
     unsigned long preRefreshSeconds = ESP_SIGNER_DEFAULT_AUTH_TOKEN_PRE_REFRESH_SECONDS;
     unsigned long expiredSeconds = ESP_SIGNER_DEFAULT_AUTH_TOKEN_EXPIRED_SECONDS;
+    /* sign the next JWT token ahead of time (during tokenReady calls) while the current token is still valid */
+    bool preSign = false;
+    /* use the self-signed JWT token as the access token without the token exchange */
+    bool selfSigned = false;
+    /* keep the connection open after the token request (Connection: keep-alive) to reuse in the next request */
+    bool keepAlive = false;
+    /* connect to the token server (DNS, TCP and SSL handshake) in the seconds before the refresh time, 0 for disable */
+    unsigned long preConnectSeconds = 0;
     /* request time out period (interval) */
     unsigned long reqTO = ESP_SIGNER_DEFAULT_REQUEST_TIMEOUT;
     MB_String customHeaders;
     MB_String pk;
+    /* RSA signing implementation, the unavailable implementation will fall back to auto */
+    esp_signer_rsa_sign_backend rsaSignBackend = esp_signer_rsa_sign_backend_auto;
     size_t hashSize = 32; // SHA256 size (256 bits or 32 bytes)
     size_t signatureSize = 256;
 
-    char *hash = nullptr;
-    unsigned char *signature = nullptr;
-    MB_String encHeader;
-    MB_String encPayload;
-    MB_String encHeadPayload;
-    MB_String encSignature;
-
     esp_signer_gauth_auth_token_info_t tokens;
 };
 
@@ -359,11 +440,142 @@ struct esp_signer_base64_io_t
     Client *outC = nullptr;
 };
 
+// the encoded output block callback e.g. to hash the output while encoding
+typedef void (*esp_signer_base64_block_cb)(void *arg, const char *data, size_t len);
+
+typedef enum
+{
+    esp_signer_http_parser_state_status_line,
+    esp_signer_http_parser_state_header,
+    esp_signer_http_parser_state_body,
+    esp_signer_http_parser_state_chunk_size,
+    esp_signer_http_parser_state_chunk_data,
+    esp_signer_http_parser_state_chunk_data_end,
+    esp_signer_http_parser_state_trailer,
+    esp_signer_http_parser_state_complete,
+    esp_signer_http_parser_state_error
+} esp_signer_http_parser_state;
+
+// the response body callback which gets the body data directly from the receive buffer
+typedef void (*esp_signer_http_body_cb)(void *arg, const char *data, size_t len);
+
+struct esp_signer_http_parser_t
+{
+    esp_signer_http_parser_state state = esp_signer_http_parser_state_status_line;
+    // the current status, header or chunk size line which is truncated to the buffer size
+    char line[ESP_SIGNER_HTTP_PARSER_LINE_SIZE];
+    size_t lineLen = 0;
+    int httpCode = 0;
+    // -1 when no Content-Length header, the body is read until the server closes the connection
+    int contentLen = -1;
+    bool chunked = false;
+    bool connectionClose = false;
+    // the remaining bytes of the body or the current chunk
+    size_t remaining = 0;
+    esp_signer_http_body_cb bodyCb = nullptr;
+    void *arg = nullptr;
+    // the header e.g. "Location: " which its value is captured in full length
+    const char *captureName = nullptr;
+    MB_String *captureValue = nullptr;
+    // 0: not checked yet, 1: capturing, 2: not the captured header, in the current line
+    uint8_t captureState = 0;
+    // the UTC timestamp of the Date header, 0 when no valid Date header
+    uint32_t date = 0;
+};
+
+typedef enum
+{
+    esp_signer_token_response_field_none,
+    esp_signer_token_response_field_access_token,
+    esp_signer_token_response_field_expires_in,
+    esp_signer_token_response_field_error,
+    esp_signer_token_response_field_error_code,
+    esp_signer_token_response_field_error_message,
+    esp_signer_token_response_field_error_description
+} esp_signer_token_response_field;
+
+// the upload progress callback with the number of bytes that were sent and the total bytes
+typedef void (*esp_signer_upload_progress_cb)(void *arg, size_t uploaded, size_t total);
+
+// the authorized API request
+struct esp_signer_api_request_t
+{
+    esp_signer_request_method method = http_undefined;
+    const char *host = nullptr;
+    // the request path and query
+    const char *path = nullptr;
+    const char *contentType = nullptr;
+    // the additional header lines e.g. "Content-Range: bytes 0-1023/2048\r\n"
+    const char *headers = nullptr;
+    // the request body source, the data in memory, the stream or the file
+    const uint8_t *body = nullptr;
+    Stream *stream = nullptr;
+    const char *filePath = nullptr;
+    esp_signer_mem_storage_type storageType = esp_signer_mem_storage_type_undefined;
+    size_t fileOffset = 0;
+    size_t bodyLen = 0;
+    // the response header which its value is captured e.g. "Location: "
+    const char *captureName = nullptr;
+    MB_String *captureValue = nullptr;
+};
+
+// the token response fields which are captured while the response body is received
+struct esp_signer_token_response_t
+{
+    // the access token destination, it is cleared and written when the access_token field was found
+    MB_String *accessToken = nullptr;
+    bool hasAccessToken = false;
+    int expiresIn = -1;
+    // the error field (string or object) was found
+    bool hasError = false;
+    // the error/code field was found
+    bool hasErrorCode = false;
+    int errorCode = 0;
+    MB_String errorMessage;
+    MB_String errorDescription;
+
+    // the scanner state
+    uint8_t state = 0;
+    // the nesting level and the object (1) or array (0) bit of each level
+    uint8_t depth = 0;
+    uint32_t objectBits = 0;
+    // the nesting level of the error object
+    uint8_t errorDepth = 0;
+    bool expectKey = false;
+    esp_signer_token_response_field field = esp_signer_token_response_field_none;
+    char key[ESP_SIGNER_TOKEN_RESPONSE_KEY_SIZE];
+    uint8_t keyLen = 0;
+    // the number value or the number in string
+    char num[12];
+    uint8_t numLen = 0;
+    // the unicode escape sequence
+    uint16_t unicode = 0;
+    uint8_t unicodeLen = 0;
+};
+
 struct esp_signer_gauth_auth_cert_t
 {
     const char *data = "";
     MB_String file;
     esp_signer_mem_storage_type file_storage = esp_signer_mem_storage_type_flash;
+    /* the seconds to keep the pin of the verified server certificate chain, the same chain is not verified again (0 to disable) */
+    uint32_t pin_ttl = 0;
+};
+
+struct esp_signer_gauth_token_cache_t
+{
+    /* the token cache file path, the cache is disabled when no path assigned */
+    MB_String path;
+    esp_signer_mem_storage_type storage_type = esp_signer_mem_storage_type_flash;
+    /* the optional AES key (16, 24 or 32 bytes) to encrypt the cache file with AES-GCM */
+    const uint8_t *aes_key = nullptr;
+    size_t aes_key_len = 0;
+};
+
+struct esp_signer_gauth_dns_cache_t : public esp_signer_gauth_token_cache_t
+{
+    /* the seconds that the resolved host address will be used without resolving again, 0 for disable */
+    unsigned long ttl = 0;
 };
 
 struct esp_signer_gauth_cfg_int_t
@@ -384,7 +596,12 @@ struct esp_signer_gauth_cfg_int_t
 
     /* flag set when NTP time server synching has been started */
     bool clock_synched = false;
+    /* flag set when NTP time server request was sent in non-blocking mode */
+    bool ntp_requested = false;
     float gmt_offset = 0;
+    /* the last difference in seconds between the server Date header (round trip compensated) and the device clock */
+    int clock_skew = 0;
+    unsigned long last_clock_request_millis = 0;
     bool auth_uri = false;
 
     MB_String auth_token;
@@ -514,7 +731,14 @@ struct esp_signer_gauth_cfg_t
 
     struct esp_signer_gauth_service_account_t service_account;
     float time_zone = 0;
+    /* set and adjust the clock from the Date header of the verified server responses instead of NTP server */
+    bool http_date_clock = false;
     struct esp_signer_gauth_auth_cert_t cert;
+    struct esp_signer_gauth_token_cache_t token_cache;
+    /* the TLS session parameters file to resume the TLS session after device restarted (same options as token_cache) */
+    struct esp_signer_gauth_token_cache_t tls_session_cache;
+    /* the resolved host addresses cache, the file (optional) keeps the addresses as the fallback after device restarted */
+    struct esp_signer_gauth_dns_cache_t dns_cache;
     struct esp_signer_gauth_token_signer_resources_t signer;
     struct esp_signer_gauth_cfg_int_t internal;
     TokenStatusCallback token_status_callback = NULL;
@@ -588,6 +812,12 @@ static const char esp_signer_gauth_pgm_str_43[] PROGMEM = "error_description";
 static const char esp_signer_gauth_pgm_str_44[] PROGMEM = "access_token";
 static const char esp_signer_gauth_pgm_str_45[] PROGMEM = "Bearer ";
 static const char esp_signer_gauth_pgm_str_46[] PROGMEM = "https://www.googleapis.com/auth/cloud-platform";
+static const char esp_signer_gauth_pgm_str_47[] PROGMEM = "kid";
+// Base64url encoded JWT header {"alg":"RS256","typ":"JWT"}
+static const char esp_signer_gauth_pgm_str_48[] PROGMEM = "eyJhbGciOiJSUzI1NiIsInR5cCI6IkpXVCJ9";
+static const char esp_signer_gauth_pgm_str_49[] PROGMEM = "code";
+static const char esp_signer_gauth_pgm_str_50[] PROGMEM = "message";
+static const char esp_signer_gauth_pgm_str_51[] PROGMEM = "\"}";
 
 static const char esp_signer_pgm_str_1[] PROGMEM = "\r\n";
 static const char esp_signer_pgm_str_2[] PROGMEM = ".";
@@ -638,5 +868,19 @@ static const char esp_signer_pgm_str_46[] PROGMEM = "error";
 static const char esp_signer_pgm_str_47[] PROGMEM = "code: ";
 static const char esp_signer_pgm_str_48[] PROGMEM = ", message: ";
 static const char esp_signer_pgm_str_49[] PROGMEM = "ready";
+static const char esp_signer_pgm_str_50[] PROGMEM = "close";
+static const char esp_signer_pgm_str_51[] PROGMEM = "Date: ";
+static const char esp_signer_pgm_str_52[] PROGMEM = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+static const char esp_signer_gcs_pgm_str_1[] PROGMEM = "storage.googleapis.com";
+static const char esp_signer_gcs_pgm_str_2[] PROGMEM = "/upload/storage/v1/b/";
+static const char esp_signer_gcs_pgm_str_3[] PROGMEM = "/o?uploadType=resumable&name=";
+static const char esp_signer_gcs_pgm_str_4[] PROGMEM = "X-Upload-Content-Type: ";
+static const char esp_signer_gcs_pgm_str_5[] PROGMEM = "X-Upload-Content-Length: ";
+static const char esp_signer_gcs_pgm_str_6[] PROGMEM = "Content-Range: bytes ";
+static const char esp_signer_gcs_pgm_str_7[] PROGMEM = "Location: ";
+static const char esp_signer_gcs_pgm_str_8[] PROGMEM = "Range: ";
+static const char esp_signer_gcs_pgm_str_9[] PROGMEM = "application/octet-stream";
+static const char esp_signer_gcs_pgm_str_10[] PROGMEM = "*/";
 
 #endif
\ No newline at end of file
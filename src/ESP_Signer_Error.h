@@ -30,10 +30,12 @@
 
 /// HTTP codes see RFC7231
 #define ESP_SIGNER_ERROR_HTTP_CODE_OK 200
+#define ESP_SIGNER_ERROR_HTTP_CODE_CREATED 201
 #define ESP_SIGNER_ERROR_HTTP_CODE_NON_AUTHORITATIVE_INFORMATION 203
 #define ESP_SIGNER_ERROR_HTTP_CODE_NO_CONTENT 204
 #define ESP_SIGNER_ERROR_HTTP_CODE_MOVED_PERMANENTLY 301
 #define ESP_SIGNER_ERROR_HTTP_CODE_FOUND 302
+#define ESP_SIGNER_ERROR_HTTP_CODE_NOT_MODIFIED 304
 #define ESP_SIGNER_ERROR_HTTP_CODE_USE_PROXY 305
 #define ESP_SIGNER_ERROR_HTTP_CODE_TEMPORARY_REDIRECT 307
 #define ESP_SIGNER_ERROR_HTTP_CODE_PERMANENT_REDIRECT 308
@@ -0,0 +1,24 @@
+/**
+ * The Google root CA trust anchors for the server certificate verification, ESP_Signer_Google_TA.h
+ *
+ * The trust anchors were generated from the DER encoded certificates of Google Trust Services root CAs
+ * (https://pki.goog/repository/) and the GlobalSign root CAs that cross-sign them, the subject DN and the public key
+ * are used by the X.509 engine directly without decoding the certificate and allocating memory at runtime.
+ *
+ * The arrays are defined once in ESP_Signer_Google_TA.cpp, they are not placed in PROGMEM because the X.509 engine
+ * reads them with the regular memory access (ESP32 and RP2040 keep the const data in flash).
+ *
+ * Created October 16, 2026
+ */
+
+#ifndef ESP_SIGNER_GOOGLE_TA_H
+#define ESP_SIGNER_GOOGLE_TA_H
+
+#include <Arduino.h>
+#include "client/SSLClient/ESP_SSLClient.h"
+
+#define ESP_SIGNER_GOOGLE_TA_NUM 6
+
+extern const br_x509_trust_anchor esp_signer_google_tas[ESP_SIGNER_GOOGLE_TA_NUM];
+
+#endif
@@ -82,6 +82,40 @@ namespace TimeHelper
         return ts;
     }
 
+    /* Parse the HTTP Date header value (IMF-fixdate) e.g. "Sun, 06 Nov 1994 08:49:37 GMT" to UTC timestamp,
+     * returns 0 when the date is invalid */
+    inline uint32_t parseHttpDate(const char *date)
+    {
+        const char *p = strchr(date, ',');
+
+        // ", 06 Nov 1994 08:49:37"
+        if (!p || strlen(p) < 22)
+            return 0;
+
+        int mon = 0;
+        for (; mon < 12; mon++)
+        {
+            PGM_P name = esp_signer_pgm_str_52 /* "JanFebMarAprMayJunJulAugSepOctNovDec" */ + mon * 3;
+            if (p[5] == (char)pgm_read_byte(name) && p[6] == (char)pgm_read_byte(name + 1) && p[7] == (char)pgm_read_byte(name + 2))
+                break;
+        }
+
+        int day = atoi(p + 2), year = atoi(p + 9), hour = atoi(p + 14), mins = atoi(p + 17), sec = atoi(p + 20);
+
+        if (mon == 12 || day < 1 || day > 31 || year < 1970 || hour > 23 || mins > 59 || sec > 60)
+            return 0;
+
+        // The days from civil date which its year begins in March, the time zone is not applied as mktime does
+        if (mon < 2)
+            year--;
+        uint32_t era = year / 400;
+        uint32_t yoe = year - era * 400;
+        uint32_t doy = (153 * (mon < 2 ? mon + 10 : mon - 2) + 2) / 5 + day - 1;
+        uint32_t days = era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+
+        return days * 86400 + hour * 3600 + mins * 60 + sec;
+    }
+
     inline uint32_t getTime(uint32_t *mb_ts, uint32_t *mb_ts_offset)
     {
 #if defined(ESP32) || defined(ESP8266) || defined(MB_ARDUINO_PICO)
@@ -157,7 +191,7 @@ namespace TimeHelper
         return clock_rdy;
     }
 
-    inline void ntpGetTime(esp_signer_gauth_cfg_t *config, uint32_t *mb_ts, float gmtOffset)
+    inline void ntpGetTime(esp_signer_gauth_cfg_t *config, uint32_t *mb_ts, float gmtOffset, bool wait = true)
     {
         uint32_t &sys_ts = *mb_ts;
 
@@ -171,15 +205,21 @@ namespace TimeHelper
 
             if (WiFI_CONNECTED)
             {
-
+                // In non-blocking mode, the NTP request will be sent once and the time will be checked without waiting.
+                if (wait || !config->internal.ntp_requested)
+                {
 #if defined(ESP_SIGNER_ENABLE_NTP_TIME)
 #if (defined(ESP32) || defined(ESP8266))
-                configTime(gmtOffset * 3600, 0 * 60, "pool.ntp.org", "time.nist.gov");
+                    configTime(gmtOffset * 3600, 0 * 60, "pool.ntp.org", "time.nist.gov");
 #elif defined(ARDUINO_RASPBERRY_PI_PICO_W)
-                NTP.begin("pool.ntp.org", "time.nist.gov");
-                NTP.waitSet();
+                    NTP.begin("pool.ntp.org", "time.nist.gov");
+                    if (wait)
+                        NTP.waitSet();
 #endif
 #endif
+                    config->internal.ntp_requested = true;
+                }
+
                 unsigned long ms = millis();
                 do
                 {
@@ -190,6 +230,8 @@ namespace TimeHelper
 #else
                     break;
 #endif
+                    if (!wait)
+                        break;
                     delay(100);
                 } while (millis() - ms < 10000 && sys_ts < ESP_SIGNER_DEFAULT_TS);
             }
@@ -201,13 +243,14 @@ namespace TimeHelper
         {
             config->internal.gmt_offset = gmtOffset;
             config->internal.clock_synched = true;
+            config->internal.ntp_requested = false;
         }
     }
 
-    inline bool syncClock(uint32_t *mb_ts, uint32_t *mb_ts_offset, float gmtOffset, esp_signer_gauth_cfg_t *config)
+    inline bool syncClock(uint32_t *mb_ts, uint32_t *mb_ts_offset, float gmtOffset, esp_signer_gauth_cfg_t *config, bool wait = true)
     {
 
-        ntpGetTime(config, mb_ts, gmtOffset);
+        ntpGetTime(config, mb_ts, gmtOffset, wait);
 
         return clockReady(mb_ts, mb_ts_offset, true);
     }
@@ -1045,6 +1088,171 @@ namespace Base64Helper
         MemoryHelper::freeBuffer(mbfs, base64EncBuf);
         return ret;
     }
+
+    // The unpadded Base64url encoded length
+    inline size_t encodedUrlLength(size_t len)
+    {
+        return (len * 4 + 2) / 3;
+    }
+
+    inline char urlChar(uint8_t v)
+    {
+        if (v == 62)
+            return '-';
+        if (v == 63)
+            return '_';
+        return (char)esp_signer_base64_table[v];
+    }
+
+    // Base64url encode (unpadded) in place.
+    // The len bytes of input data should be placed at the tail of the output buffer, i.e. at
+    // buf + encodedUrlLength(len) - len, the output will be written from the beginning of buf.
+    // The encoding can be done forward without overwriting the unread input because the
+    // output is always behind the input (the offset is ceil(len / 3) bytes).
+    // The optional block callback receives the encoded output in 64-byte blocks while it is still in cache
+    // e.g. to feed the running message digest in the same pass.
+    inline size_t encodeUrlInPlace(char *buf, size_t len, esp_signer_base64_block_cb blockCb = nullptr, void *arg = nullptr)
+    {
+        size_t encLen = encodedUrlLength(len);
+        const uint8_t *in = (const uint8_t *)buf + encLen - len;
+        char *p = buf;
+        char *block = buf;
+        size_t i = 0;
+
+        for (; i + 2 < len; i += 3)
+        {
+            uint8_t b0 = in[i], b1 = in[i + 1], b2 = in[i + 2];
+            *p++ = urlChar(b0 >> 2);
+            *p++ = urlChar(((b0 & 0x3) << 4) | (b1 >> 4));
+            *p++ = urlChar(((b1 & 0xF) << 2) | (b2 >> 6));
+            *p++ = urlChar(b2 & 0x3F);
+
+            if (blockCb && p - block >= 64)
+            {
+                blockCb(arg, block, 64);
+                block += 64;
+            }
+        }
+
+        if (i < len)
+        {
+            uint8_t b0 = in[i], b1 = i + 1 < len ? in[i + 1] : 0;
+            *p++ = urlChar(b0 >> 2);
+            *p++ = urlChar(((b0 & 0x3) << 4) | (b1 >> 4));
+            if (i + 1 < len)
+                *p++ = urlChar((b1 & 0xF) << 2);
+        }
+
+        if (blockCb && p > block)
+            blockCb(arg, block, p - block);
+
+        return encLen;
+    }
+};
+
+namespace JWTHelper
+{
+    // The JSON writer functions below write to out and return the number of bytes written,
+    // when out is null, the bytes are counted only (first pass to get the buffer size).
+
+    inline size_t putChar(char *out, char c)
+    {
+        if (out)
+            *out = c;
+        return 1;
+    }
+
+    inline size_t putRaw(char *out, PGM_P str)
+    {
+        size_t len = strlen_P(str);
+        if (out)
+            memcpy_P(out, str, len);
+        return len;
+    }
+
+    // Write the string (which can be stored in flash memory) without quotes, the quote and backslash will be escaped
+    inline size_t putEscaped(char *out, const char *str, size_t len)
+    {
+        size_t n = 0;
+        for (size_t i = 0; i < len; i++)
+        {
+            char c = pgm_read_byte(str + i);
+            if (c == '"' || c == '\\')
+                n += putChar(out ? out + n : nullptr, '\\');
+            n += putChar(out ? out + n : nullptr, c);
+        }
+        return n;
+    }
+
+    // Write the JSON string value with quotes
+    inline size_t putStr(char *out, const char *str)
+    {
+        size_t n = putChar(out, '"');
+        n += putEscaped(out ? out + n : nullptr, str, strlen_P(str));
+        n += putChar(out ? out + n : nullptr, '"');
+        return n;
+    }
+
+    // Write the JSON key with the leading comma (if not first) and colon e.g. ,"key":
+    inline size_t putKey(char *out, PGM_P key, bool first)
+    {
+        size_t n = first ? 0 : putChar(out, ',');
+        n += putStr(out ? out + n : nullptr, key);
+        n += putChar(out ? out + n : nullptr, ':');
+        return n;
+    }
+
+    inline size_t putInt(char *out, uint32_t val)
+    {
+        char buf[11];
+        size_t len = 0;
+        do
+        {
+            buf[len++] = '0' + (val % 10);
+            val /= 10;
+        } while (val > 0);
+
+        if (out)
+        {
+            for (size_t i = 0; i < len; i++)
+                out[i] = buf[len - 1 - i];
+        }
+        return len;
+    }
+
+    // Write the comma separated scope as the space separated JSON string value
+    inline size_t putScope(char *out, const char *scope)
+    {
+        size_t n = putChar(out, '"');
+        size_t len = strlen(scope), i = 0;
+        bool first = true;
+
+        while (i < len)
+        {
+            size_t end = i;
+            while (end < len && scope[end] != ',')
+                end++;
+
+            size_t s = i, e = end;
+            while (s < e && scope[s] == ' ')
+                s++;
+            while (e > s && scope[e - 1] == ' ')
+                e--;
+
+            if (e > s)
+            {
+                if (!first)
+                    n += putChar(out ? out + n : nullptr, ' ');
+                n += putEscaped(out ? out + n : nullptr, scope + s, e - s);
+                first = false;
+            }
+
+            i = end + 1;
+        }
+
+        n += putChar(out ? out + n : nullptr, '"');
+        return n;
+    }
 };
 
 namespace HttpHelper
@@ -1151,6 +1359,88 @@ namespace HttpHelper
         header += esp_signer_pgm_str_18; // "Bearer "
     }
 
+    // The request writer functions below write to out and return the number of bytes written,
+    // when out is null, the bytes are counted only (first pass to get the exact request size).
+
+    /* Write the string as is */
+    inline size_t putText(char *out, const char *str)
+    {
+        size_t len = strlen(str);
+        if (out)
+            memcpy(out, str, len);
+        return len;
+    }
+
+    /* Write the percent encoded string e.g. the object name in query, only the unreserved characters are kept */
+    inline size_t putUrlEncoded(char *out, const char *str)
+    {
+        static const char hex[] = "0123456789ABCDEF";
+        size_t n = 0;
+        for (; *str; str++)
+        {
+            unsigned char c = *str;
+            if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+                n += JWTHelper::putChar(out ? out + n : nullptr, c);
+            else
+            {
+                n += JWTHelper::putChar(out ? out + n : nullptr, '%');
+                n += JWTHelper::putChar(out ? out + n : nullptr, hex[c >> 4]);
+                n += JWTHelper::putChar(out ? out + n : nullptr, hex[c & 0xf]);
+            }
+        }
+        return n;
+    }
+
+    /* Write the first part of request line (HTTP method) */
+    inline size_t putRequestFirst(char *out, esp_signer_request_method method)
+    {
+        PGM_P m = esp_signer_pgm_str_10; // "GET"
+        if (method == http_post)
+            m = esp_signer_pgm_str_11; // "POST"
+        else if (method == http_patch)
+            m = esp_signer_pgm_str_12; // "PATCH"
+        else if (method == http_delete)
+            m = esp_signer_pgm_str_13; // "DELETE"
+        else if (method == http_put)
+            m = esp_signer_pgm_str_14; // "PUT"
+
+        size_t n = JWTHelper::putRaw(out, m);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_15 /* " " */);
+        return n;
+    }
+
+    /* Write the last part of request line (HTTP version) and the Host and User-Agent headers */
+    inline size_t putRequestLast(char *out, PGM_P sub)
+    {
+        size_t n = JWTHelper::putRaw(out, esp_signer_pgm_str_16 /* " HTTP/1.1\r\n" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_4 /* "Host: " */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, sub);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_2 /* "." */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_3 /* "googleapis.com" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_7 /* "User-Agent: ESP\r\n" */);
+        return n;
+    }
+
+    /* Write the content headers and the empty line that ends the header */
+    inline size_t putContentHeaders(char *out, size_t len, PGM_P type)
+    {
+        size_t n = JWTHelper::putRaw(out, esp_signer_pgm_str_6 /* "Content-Length: " */);
+        n += JWTHelper::putInt(out ? out + n : nullptr, len);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_5 /* "Content-Type: " */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, type);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+        return n;
+    }
+
+    inline size_t putConnectionHeader(char *out, bool keepAlive)
+    {
+        return JWTHelper::putRaw(out, keepAlive ? esp_signer_pgm_str_8 /* "Connection: keep-alive\r\n" */
+                                                : esp_signer_pgm_str_9 /* "Connection: close\r\n" */);
+    }
+
     inline void parseRespHeader(const MB_String &src, struct esp_signer_server_response_data_t &response)
     {
         int beginPos = 0;
@@ -1496,6 +1786,598 @@ namespace HttpHelper
 
 };
 
+namespace HttpParser
+{
+    /* begin the next response e.g. after the informational response, the body callback and the captured header are kept */
+    inline void beginResponse(esp_signer_http_parser_t &parser)
+    {
+        parser.state = esp_signer_http_parser_state_status_line;
+        parser.line[0] = '\0';
+        parser.lineLen = 0;
+        parser.httpCode = 0;
+        parser.contentLen = -1;
+        parser.chunked = false;
+        parser.connectionClose = false;
+        parser.remaining = 0;
+        parser.captureState = 0;
+        parser.date = 0;
+    }
+
+    /* reset all fields of the reused parser for the new request */
+    inline void reset(esp_signer_http_parser_t &parser, esp_signer_http_body_cb bodyCb = nullptr, void *arg = nullptr,
+                      const char *captureName = nullptr, MB_String *captureValue = nullptr)
+    {
+        beginResponse(parser);
+        parser.bodyCb = bodyCb;
+        parser.arg = arg;
+        parser.captureName = captureName;
+        parser.captureValue = captureValue;
+    }
+
+    inline bool isComplete(const esp_signer_http_parser_t &parser)
+    {
+        return parser.state == esp_signer_http_parser_state_complete;
+    }
+
+    inline bool isError(const esp_signer_http_parser_t &parser)
+    {
+        return parser.state == esp_signer_http_parser_state_error;
+    }
+
+    /* the body without Content-Length and chunked encoding is ended when the server closes the connection */
+    inline bool isReadUntilClose(const esp_signer_http_parser_t &parser)
+    {
+        return parser.state == esp_signer_http_parser_state_body && parser.contentLen < 0;
+    }
+
+    /* returns the header value when the line is the header field e.g. "Content-Length: " (case insensitive) */
+    inline const char *headerValue(const char *line, PGM_P field)
+    {
+        size_t i = 0;
+        char c = pgm_read_byte(field);
+        while (c != ':')
+        {
+            if (tolower(line[i]) != tolower(c))
+                return nullptr;
+            c = pgm_read_byte(field + ++i);
+        }
+
+        if (line[i] != ':')
+            return nullptr;
+
+        line += i + 1;
+        while (*line == ' ' || *line == '\t')
+            line++;
+
+        return line;
+    }
+
+    /* the header value contains the token e.g. "chunked" (case insensitive) */
+    inline bool hasToken(const char *value, PGM_P token)
+    {
+        size_t len = strlen_P(token);
+        for (; *value; value++)
+        {
+            size_t i = 0;
+            while (i < len && value[i] && tolower(value[i]) == tolower(pgm_read_byte(token + i)))
+                i++;
+            if (i == len)
+                return true;
+        }
+        return false;
+    }
+
+    /* the status line, header and trailer are ended, set the next state */
+    inline void endHeader(esp_signer_http_parser_t &parser)
+    {
+        // skip the informational (1xx) response header and wait for the final response
+        if (parser.httpCode >= 100 && parser.httpCode < 200)
+            beginResponse(parser);
+        else if (parser.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_NO_CONTENT ||
+                 parser.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_NOT_MODIFIED)
+            parser.state = esp_signer_http_parser_state_complete;
+        else if (parser.chunked)
+            parser.state = esp_signer_http_parser_state_chunk_size;
+        else if (parser.contentLen == 0)
+            parser.state = esp_signer_http_parser_state_complete;
+        else
+        {
+            parser.state = esp_signer_http_parser_state_body;
+            parser.remaining = parser.contentLen > 0 ? parser.contentLen : 0;
+        }
+    }
+
+    /* capture the header value which can be longer than the line buffer, span is the line data that was just copied
+     * to the line buffer (copyLen bytes) and the rest which was not fit */
+    inline void captureHeader(esp_signer_http_parser_t &parser, const char *span, size_t len, size_t copyLen)
+    {
+        if (parser.captureState == 1)
+        {
+            // the leading spaces of the value can be in the next span
+            while (len > 0 && parser.captureValue->length() == 0 && (*span == ' ' || *span == '\t'))
+            {
+                span++;
+                len--;
+            }
+            parser.captureValue->append(span, len);
+            return;
+        }
+
+        if (parser.captureState != 0)
+            return;
+
+        // wait until the header name was received
+        if (parser.lineLen < strlen_P(parser.captureName) && copyLen == len)
+            return;
+
+        parser.line[parser.lineLen] = '\0';
+        const char *value = headerValue(parser.line, parser.captureName);
+        parser.captureState = value ? 1 : 2;
+
+        if (value)
+        {
+            parser.captureValue->clear();
+            parser.captureValue->append(value, parser.line + parser.lineLen - value);
+            parser.captureValue->append(span + copyLen, len - copyLen);
+        }
+    }
+
+    /* process the complete line */
+    inline void parseLine(esp_signer_http_parser_t &parser)
+    {
+        if (parser.captureState == 1)
+        {
+            size_t len = parser.captureValue->length();
+            if (len > 0 && (*parser.captureValue)[len - 1] == '\r')
+                parser.captureValue->pop_back();
+        }
+        parser.captureState = 0;
+
+        if (parser.lineLen > 0 && parser.line[parser.lineLen - 1] == '\r')
+            parser.lineLen--;
+        parser.line[parser.lineLen] = '\0';
+
+        const char *value = nullptr;
+
+        switch (parser.state)
+        {
+        case esp_signer_http_parser_state_status_line:
+            // e.g. HTTP/1.1 200 OK
+            value = strchr(parser.line, ' ');
+            if (strncmp(parser.line, "HTTP/", 5) != 0 || !value)
+                parser.state = esp_signer_http_parser_state_error;
+            else
+            {
+                parser.httpCode = atoi(value + 1);
+                parser.state = esp_signer_http_parser_state_header;
+            }
+            break;
+
+        case esp_signer_http_parser_state_header:
+            if (parser.lineLen == 0)
+                endHeader(parser);
+            else if ((value = headerValue(parser.line, esp_signer_pgm_str_22 /* "Content-Length: " */)) != nullptr)
+                parser.contentLen = atoi(value);
+            else if ((value = headerValue(parser.line, esp_signer_pgm_str_24 /* "Transfer-Encoding: " */)) != nullptr)
+                parser.chunked = hasToken(value, esp_signer_pgm_str_25 /* "chunked" */);
+            else if ((value = headerValue(parser.line, esp_signer_pgm_str_20 /* "Connection: " */)) != nullptr)
+                parser.connectionClose = hasToken(value, esp_signer_pgm_str_50 /* "close" */);
+            else if ((value = headerValue(parser.line, esp_signer_pgm_str_51 /* "Date: " */)) != nullptr)
+                parser.date = TimeHelper::parseHttpDate(value);
+            break;
+
+        case esp_signer_http_parser_state_chunk_size:
+            // the chunk extension after the size is ignored
+            parser.remaining = strtoul(parser.line, nullptr, 16);
+            if (parser.remaining > 0)
+                parser.state = esp_signer_http_parser_state_chunk_data;
+            else if (parser.line[0] == '0')
+                parser.state = esp_signer_http_parser_state_trailer;
+            else
+                parser.state = esp_signer_http_parser_state_error;
+            break;
+
+        case esp_signer_http_parser_state_chunk_data_end:
+            parser.state = parser.lineLen == 0 ? esp_signer_http_parser_state_chunk_size : esp_signer_http_parser_state_error;
+            break;
+
+        case esp_signer_http_parser_state_trailer:
+            if (parser.lineLen == 0)
+                parser.state = esp_signer_http_parser_state_complete;
+            break;
+
+        default:
+            break;
+        }
+
+        parser.lineLen = 0;
+    }
+
+    /* parse the received data in place, the body data is passed to the body callback without copy,
+     * returns the number of bytes that were processed which is less than len when the response was completed */
+    inline size_t parse(esp_signer_http_parser_t &parser, const char *data, size_t len)
+    {
+        size_t i = 0;
+
+        while (i < len && parser.state != esp_signer_http_parser_state_complete &&
+               parser.state != esp_signer_http_parser_state_error)
+        {
+            if (parser.state == esp_signer_http_parser_state_body ||
+                parser.state == esp_signer_http_parser_state_chunk_data)
+            {
+                size_t n = len - i;
+                bool untilClose = isReadUntilClose(parser);
+                if (!untilClose && n > parser.remaining)
+                    n = parser.remaining;
+
+                if (parser.bodyCb)
+                    parser.bodyCb(parser.arg, data + i, n);
+                i += n;
+
+                if (!untilClose)
+                {
+                    parser.remaining -= n;
+                    if (parser.remaining == 0)
+                        parser.state = parser.state == esp_signer_http_parser_state_body
+                                           ? esp_signer_http_parser_state_complete
+                                           : esp_signer_http_parser_state_chunk_data_end;
+                }
+                continue;
+            }
+
+            const char *lf = (const char *)memchr(data + i, '\n', len - i);
+            size_t n = lf ? (size_t)(lf - (data + i)) : len - i;
+
+            // keep only the leading part of the long line, e.g. the long header value is not needed
+            size_t copyLen = sizeof(parser.line) - 1 - parser.lineLen;
+            if (copyLen > n)
+                copyLen = n;
+            memcpy(parser.line + parser.lineLen, data + i, copyLen);
+            parser.lineLen += copyLen;
+
+            if (parser.state == esp_signer_http_parser_state_header && parser.captureValue)
+                captureHeader(parser, data + i, n, copyLen);
+
+            i += n;
+
+            if (!lf)
+                break;
+
+            i++;
+            parseLine(parser);
+        }
+
+        return i;
+    }
+
+};
+
+namespace TokenResponseHelper
+{
+    enum
+    {
+        scan_state_idle,
+        scan_state_key,
+        scan_state_key_escape,
+        scan_state_string,
+        scan_state_string_escape,
+        scan_state_string_unicode,
+        scan_state_scalar
+    };
+
+    /* the scanned key equals the PROGMEM key name */
+    inline bool isKey(const esp_signer_token_response_t &resp, PGM_P key)
+    {
+        uint8_t i = 0;
+        for (; i < resp.keyLen; i++)
+        {
+            if (resp.key[i] != (char)pgm_read_byte(key + i))
+                return false;
+        }
+        return pgm_read_byte(key + i) == '\0';
+    }
+
+    inline bool isObject(const esp_signer_token_response_t &resp)
+    {
+        return resp.depth > 0 && resp.depth <= 32 && ((resp.objectBits >> (resp.depth - 1)) & 1);
+    }
+
+    /* select the field to capture from the key and its nesting level */
+    inline void selectField(esp_signer_token_response_t &resp)
+    {
+        resp.field = esp_signer_token_response_field_none;
+
+        if (resp.depth == 1)
+        {
+            if (isKey(resp, esp_signer_gauth_pgm_str_44 /* "access_token" */))
+                resp.field = esp_signer_token_response_field_access_token;
+            else if (isKey(resp, esp_signer_gauth_pgm_str_19 /* "expires_in" */))
+                resp.field = esp_signer_token_response_field_expires_in;
+            else if (isKey(resp, esp_signer_gauth_pgm_str_42 /* "error" */))
+                resp.field = esp_signer_token_response_field_error;
+            else if (isKey(resp, esp_signer_gauth_pgm_str_43 /* "error_description" */))
+                resp.field = esp_signer_token_response_field_error_description;
+        }
+        else if (resp.errorDepth > 0 && resp.depth == resp.errorDepth)
+        {
+            if (isKey(resp, esp_signer_gauth_pgm_str_49 /* "code" */))
+                resp.field = esp_signer_token_response_field_error_code;
+            else if (isKey(resp, esp_signer_gauth_pgm_str_50 /* "message" */))
+                resp.field = esp_signer_token_response_field_error_message;
+        }
+    }
+
+    inline MB_String *stringDest(esp_signer_token_response_t &resp)
+    {
+        switch (resp.field)
+        {
+        case esp_signer_token_response_field_access_token:
+            return resp.accessToken;
+        case esp_signer_token_response_field_error_message:
+            return &resp.errorMessage;
+        case esp_signer_token_response_field_error_description:
+            return &resp.errorDescription;
+        default:
+            return nullptr;
+        }
+    }
+
+    inline bool isNumberField(const esp_signer_token_response_t &resp)
+    {
+        return resp.field == esp_signer_token_response_field_expires_in ||
+               resp.field == esp_signer_token_response_field_error_code;
+    }
+
+    /* add the decoded string value character to the destination or the number buffer */
+    inline void putChar(esp_signer_token_response_t &resp, MB_String *dest, char c)
+    {
+        if (dest)
+            dest->append(1, c);
+        else if (isNumberField(resp) && resp.numLen < sizeof(resp.num) - 1)
+            resp.num[resp.numLen++] = c;
+    }
+
+    /* add the unicode code point (BMP) as UTF-8 */
+    inline void putUnicode(esp_signer_token_response_t &resp, MB_String *dest)
+    {
+        uint16_t u = resp.unicode;
+        if (u < 0x80)
+            putChar(resp, dest, u);
+        else if (u < 0x800)
+        {
+            putChar(resp, dest, 0xc0 | (u >> 6));
+            putChar(resp, dest, 0x80 | (u & 0x3f));
+        }
+        else
+        {
+            putChar(resp, dest, 0xe0 | (u >> 12));
+            putChar(resp, dest, 0x80 | ((u >> 6) & 0x3f));
+            putChar(resp, dest, 0x80 | (u & 0x3f));
+        }
+    }
+
+    /* the string or scalar value was ended */
+    inline void endValue(esp_signer_token_response_t &resp)
+    {
+        if (isNumberField(resp))
+        {
+            resp.num[resp.numLen] = '\0';
+            if (resp.field == esp_signer_token_response_field_expires_in)
+                resp.expiresIn = atoi(resp.num);
+            else
+            {
+                resp.errorCode = atoi(resp.num);
+                resp.hasErrorCode = true;
+            }
+        }
+
+        resp.field = esp_signer_token_response_field_none;
+        resp.state = scan_state_idle;
+    }
+
+    /* the value is started in idle state */
+    inline void beginValue(esp_signer_token_response_t &resp, char c)
+    {
+        if (resp.field == esp_signer_token_response_field_error)
+            resp.hasError = true;
+
+        resp.numLen = 0;
+
+        if (c == '"')
+        {
+            resp.state = scan_state_string;
+            MB_String *dest = stringDest(resp);
+            if (dest)
+                dest->clear();
+            if (resp.field == esp_signer_token_response_field_access_token)
+                resp.hasAccessToken = true;
+        }
+        else
+        {
+            resp.state = scan_state_scalar;
+            putChar(resp, nullptr, c);
+        }
+    }
+
+    /* scan the response body JSON and capture the known fields, the access token is written to its destination directly */
+    inline void parse(esp_signer_token_response_t &resp, const char *data, size_t len)
+    {
+        size_t i = 0;
+
+        while (i < len)
+        {
+            char c = data[i];
+
+            switch (resp.state)
+            {
+            case scan_state_idle:
+
+                if (c == '"' && resp.expectKey)
+                {
+                    resp.state = scan_state_key;
+                    resp.keyLen = 0;
+                }
+                else if (c == '{' || c == '[')
+                {
+                    // the error object fields are in the next level
+                    if (resp.field == esp_signer_token_response_field_error && c == '{')
+                    {
+                        resp.hasError = true;
+                        resp.errorDepth = resp.depth + 1;
+                    }
+
+                    resp.depth++;
+                    if (resp.depth <= 32)
+                    {
+                        if (c == '{')
+                            resp.objectBits |= (1UL << (resp.depth - 1));
+                        else
+                            resp.objectBits &= ~(1UL << (resp.depth - 1));
+                    }
+                    resp.expectKey = c == '{';
+                    resp.field = esp_signer_token_response_field_none;
+                }
+                else if (c == '}' || c == ']')
+                {
+                    if (resp.depth == resp.errorDepth)
+                        resp.errorDepth = 0;
+                    if (resp.depth > 0)
+                        resp.depth--;
+                    resp.expectKey = false;
+                    resp.field = esp_signer_token_response_field_none;
+                }
+                else if (c == ',')
+                {
+                    resp.expectKey = isObject(resp);
+                    resp.field = esp_signer_token_response_field_none;
+                }
+                else if (c != ':' && c != ' ' && c != '\t' && c != '\r' && c != '\n')
+                    beginValue(resp, c);
+
+                i++;
+                break;
+
+            case scan_state_key:
+
+                if (c == '"')
+                {
+                    resp.expectKey = false;
+                    resp.state = scan_state_idle;
+                    selectField(resp);
+                }
+                else if (c == '\\')
+                    resp.state = scan_state_key_escape;
+                else if (resp.keyLen < sizeof(resp.key))
+                    resp.key[resp.keyLen++] = c;
+
+                i++;
+                break;
+
+            case scan_state_key_escape:
+
+                // the matched key names have no escape sequence
+                if (resp.keyLen < sizeof(resp.key))
+                    resp.key[resp.keyLen++] = c;
+                resp.state = scan_state_key;
+                i++;
+                break;
+
+            case scan_state_string:
+            {
+                // append the run of unescaped characters at once
+                size_t j = i;
+                while (j < len && data[j] != '"' && data[j] != '\\')
+                    j++;
+
+                MB_String *dest = stringDest(resp);
+                if (dest)
+                    dest->append(data + i, j - i);
+                else
+                {
+                    for (size_t k = i; k < j; k++)
+                        putChar(resp, nullptr, data[k]);
+                }
+
+                i = j;
+
+                if (i < len)
+                {
+                    if (data[i] == '"')
+                        endValue(resp);
+                    else
+                        resp.state = scan_state_string_escape;
+                    i++;
+                }
+                break;
+            }
+
+            case scan_state_string_escape:
+
+                if (c == 'u')
+                {
+                    resp.state = scan_state_string_unicode;
+                    resp.unicode = 0;
+                    resp.unicodeLen = 0;
+                }
+                else
+                {
+                    if (c == 'n')
+                        c = '\n';
+                    else if (c == 't')
+                        c = '\t';
+                    else if (c == 'r')
+                        c = '\r';
+                    else if (c == 'b')
+                        c = '\b';
+                    else if (c == 'f')
+                        c = '\f';
+
+                    putChar(resp, stringDest(resp), c);
+                    resp.state = scan_state_string;
+                }
+
+                i++;
+                break;
+
+            case scan_state_string_unicode:
+
+                resp.unicode = (resp.unicode << 4) | (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+                if (++resp.unicodeLen == 4)
+                {
+                    putUnicode(resp, stringDest(resp));
+                    resp.state = scan_state_string;
+                }
+
+                i++;
+                break;
+
+            case scan_state_scalar:
+
+                // the number, true, false or null is ended by the delimiter which will be processed in idle state
+                if (c == ',' || c == '}' || c == ']' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+                    endValue(resp);
+                else
+                {
+                    putChar(resp, nullptr, c);
+                    i++;
+                }
+                break;
+
+            default:
+                i++;
+                break;
+            }
+        }
+    }
+
+    /* the HTTP response body callback */
+    inline void parseBody(void *arg, const char *data, size_t len)
+    {
+        parse(*(esp_signer_token_response_t *)arg, data, len);
+    }
+
+};
+
 namespace Utils
 {
 
@@ -1504,6 +2386,46 @@ namespace Utils
         return mbfs->calCRC(buf);
     }
 
+    // Calculate CRC16 of binary data (same polynomial as MB_FS::calCRC), the crc of the previous data can be continued.
+    inline uint16_t calCRC(const uint8_t *buf, size_t len, uint16_t crc = 0xFFFF)
+    {
+        uint8_t x;
+
+        while (len--)
+        {
+            x = crc >> 8 ^ *buf++;
+            x ^= x >> 4;
+            crc = (crc << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x << 5)) ^ ((uint16_t)x);
+        }
+        return crc;
+    }
+
+    // Compare the secret data e.g. the authentication tag in constant time.
+    inline bool equals(const uint8_t *a, const uint8_t *b, size_t len)
+    {
+        uint8_t diff = 0;
+        for (size_t i = 0; i < len; i++)
+            diff |= a[i] ^ b[i];
+        return diff == 0;
+    }
+
+    // Fill the buffer with random bytes from hardware random number generator.
+    inline void randomBytes(uint8_t *buf, size_t len)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+#if defined(ESP32)
+            buf[i] = esp_random() & 0xff;
+#elif defined(ESP8266)
+            buf[i] = RANDOM_REG32 & 0xff;
+#elif defined(MB_ARDUINO_PICO)
+            buf[i] = rp2040.hwrand32() & 0xff;
+#else
+            buf[i] = random(256);
+#endif
+        }
+    }
+
     inline bool isNoContent(esp_signer_server_response_data_t *response)
     {
         return !response->isChunkedEnc && response->contentLen == 0;
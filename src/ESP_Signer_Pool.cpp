@@ -0,0 +1,270 @@
+/**
+ * Google's OAuth2.0 Access token Generation class for multiple service accounts, ESP_Signer_Pool.cpp version 1.0.0
+ *
+ * This library supports ESP8266, ESP32 and Raspberry Pi Pico.
+ *
+ * Created October 16, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ESP_SIGNER_POOL_CPP
+#define ESP_SIGNER_POOL_CPP
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "ESP_Signer_Pool.h"
+
+SignerPool::SignerPool()
+{
+    tcpClient = new GAuth_TCP_Client();
+}
+
+SignerPool::~SignerPool()
+{
+    end();
+    if (tcpClient)
+        delete tcpClient;
+    tcpClient = nullptr;
+}
+
+void SignerPool::setExternalClient(Client *client, ESP_Signer_NetworkConnectionRequestCallback networkConnectionCB,
+                                   ESP_Signer_NetworkStatusRequestCallback networkStatusCB)
+{
+    tcpClient->setClient(client, networkConnectionCB, networkStatusCB);
+    tcpClient->setCACert(nullptr);
+}
+
+void SignerPool::setNetworkStatus(bool status)
+{
+    tcpClient->setNetworkStatus(status);
+}
+
+int SignerPool::add(SignerConfig *config)
+{
+    if (!config || !tcpClient)
+        return -1;
+
+    GAuth_OAuth2_Client *client = new GAuth_OAuth2_Client();
+
+    // All entries share the same TCP client and filesystem
+    client->tcpClient = tcpClient;
+    client->sharedTCPClient = true;
+
+    client->begin(config, &mbfs, &mb_ts, &mb_ts_offset);
+    client->reset();
+
+#if defined(ESP32) || defined(ESP8266)
+    config->internal.reconnect_wifi = WiFi.getAutoReconnect();
+#endif
+    config->signer.tokens.token_type = token_type_oauth2_access_token;
+
+    // Restore the valid token from the cache file when the device time is already set,
+    // the TLS session is restored only when the shared TCP client has no session for its host
+    client->loadTokenCache();
+    client->loadTLSSession();
+    client->loadDNSCache();
+
+    clients.push_back(client);
+    retryMillis.push_back(0);
+    retryInterval.push_back(0);
+
+    return clients.size() - 1;
+}
+
+void SignerPool::end()
+{
+    for (size_t i = 0; i < clients.size(); i++)
+        delete clients[i];
+    clients.clear();
+    retryMillis.clear();
+    retryInterval.clear();
+    active = -1;
+    last = -1;
+}
+
+size_t SignerPool::size()
+{
+    return clients.size();
+}
+
+GAuth_OAuth2_Client *SignerPool::getClient(int index)
+{
+    if (index < 0 || index >= (int)clients.size())
+        return nullptr;
+    return clients[index];
+}
+
+int SignerPool::nextDueEntry()
+{
+    int n = clients.size();
+
+    for (int i = 1; i <= n; i++)
+    {
+        int idx = (last + i) % n;
+        GAuth_OAuth2_Client *client = clients[idx];
+        time_t due = client->nextDueTime();
+
+        // The failed entry e.g. the invalid service account file is not processed again in every call
+        if (client->config->signer.tokens.status == esp_signer_token_status_error &&
+            millis() - retryMillis[idx] < retryInterval[idx])
+            continue;
+
+        if (due == 0 || client->getTime() >= due)
+            return idx;
+    }
+
+    return -1;
+}
+
+void SignerPool::updateRetry(int index)
+{
+    if (clients[index]->config->signer.tokens.status != esp_signer_token_status_error)
+    {
+        retryInterval[index] = 0;
+        return;
+    }
+
+    if (retryInterval[index] == 0)
+        retryInterval[index] = ESP_SIGNER_POOL_RETRY_MIN_INTERVAL;
+    else if (retryInterval[index] < ESP_SIGNER_POOL_RETRY_MAX_INTERVAL / 2)
+        retryInterval[index] *= 2;
+    else
+        retryInterval[index] = ESP_SIGNER_POOL_RETRY_MAX_INTERVAL;
+
+    retryMillis[index] = millis();
+}
+
+bool SignerPool::poll(uint32_t budget_us)
+{
+    if (clients.size() == 0)
+        return false;
+
+    unsigned long start = micros();
+    size_t count = 0;
+
+    do
+    {
+        // The entry that its token request is in progress owns the shared TCP client until its request was done
+        if (active < 0)
+        {
+            active = nextDueEntry();
+            if (active < 0)
+                break;
+            last = active;
+        }
+
+        GAuth_OAuth2_Client *client = clients[active];
+
+        uint32_t used = micros() - start;
+        client->poll(used < budget_us ? budget_us - used : 0);
+
+        // The request is still in progress (e.g. waiting for the response), continue in the next call
+        if (client->isBusy())
+            break;
+
+        // The entry is done or should wait (e.g. for the clock), let the next due entry run
+        updateRetry(active);
+        active = -1;
+
+    } while (++count < clients.size() && micros() - start < budget_us);
+
+    for (size_t i = 0; i < clients.size(); i++)
+    {
+        if (clients[i]->config->signer.tokens.status != esp_signer_token_status_ready)
+            return false;
+    }
+
+    return true;
+}
+
+bool SignerPool::tokenReady(int index)
+{
+    GAuth_OAuth2_Client *client = getClient(index);
+    return client && client->config->signer.tokens.status == esp_signer_token_status_ready;
+}
+
+const char *SignerPool::tokenSnapshot(int index)
+{
+    return tokenReady(index) ? clients[index]->config->internal.auth_token.c_str() : "";
+}
+
+size_t SignerPool::tokenSnapshot(int index, char *buf, size_t size)
+{
+    if (!buf || size == 0)
+        return 0;
+
+    buf[0] = '\0';
+    if (!tokenReady(index))
+        return 0;
+
+    MB_String &token = clients[index]->config->internal.auth_token;
+    size_t len = token.length() < size ? token.length() : size - 1;
+    memcpy(buf, token.c_str(), len);
+    buf[len] = '\0';
+    return len;
+}
+
+String SignerPool::accessToken(int index)
+{
+    GAuth_OAuth2_Client *client = getClient(index);
+    if (!client)
+        return "";
+    return client->config->internal.auth_token.c_str();
+}
+
+String SignerPool::getTokenStatus(int index)
+{
+    GAuth_OAuth2_Client *client = getClient(index);
+    if (!client)
+        return "";
+    return client->getTokenStatus();
+}
+
+String SignerPool::getTokenError(int index)
+{
+    GAuth_OAuth2_Client *client = getClient(index);
+    if (!client)
+        return "";
+    return client->getTokenError();
+}
+
+unsigned long SignerPool::getExpiredTimestamp(int index)
+{
+    GAuth_OAuth2_Client *client = getClient(index);
+    if (!client)
+        return 0;
+    return client->getExpiredTimestamp();
+}
+
+void SignerPool::refreshToken(int index)
+{
+    GAuth_OAuth2_Client *client = getClient(index);
+
+    // The token will be requested by the scheduler, the shared TCP client may be in use by other entry
+    if (client)
+    {
+        client->config->signer.tokens.expires = 0;
+        retryInterval[index] = 0;
+    }
+}
+
+#endif
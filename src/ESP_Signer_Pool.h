@@ -0,0 +1,202 @@
+/**
+ * Google's OAuth2.0 Access token Generation class for multiple service accounts, ESP_Signer_Pool.h version 1.0.0
+ *
+ * The token tasks of all entries are processed one at a time by a single scheduler with the shared TCP client.
+ *
+ * This library supports ESP8266, ESP32 and Raspberry Pi Pico.
+ *
+ * Created October 16, 2026
+ *
+ * The MIT License (MIT)
+ * Copyright (c) 2023 K. Suwatchai (Mobizt)
+ *
+ *
+ * Permission is hereby granted, free of charge, to any person returning a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ESP_SIGNER_POOL_H
+#define ESP_SIGNER_POOL_H
+
+#include <Arduino.h>
+#include "mbfs/MB_MCU.h"
+#include "ESP_Signer_Helper.h"
+#include "auth/GAuth_OAuth2_Client.h"
+
+class SignerPool
+{
+
+public:
+    SignerPool();
+    ~SignerPool();
+
+    // The entries and the shared TCP client are owned by the pool
+    SignerPool(const SignerPool &) = delete;
+    SignerPool &operator=(const SignerPool &) = delete;
+
+    /** Assign external Arduino Client and required callback fumctions.
+     *
+     * @param client The pointer to Arduino Client derived class of SSL Client.
+     * @param networkConnectionCB The function that handles the network connection.
+     * @param networkStatusCB The function that handle the network connection status acknowledgement.
+     *
+     * The client is shared by all entries.
+     */
+    void setExternalClient(Client *client, ESP_Signer_NetworkConnectionRequestCallback networkConnectionCB,
+                           ESP_Signer_NetworkStatusRequestCallback networkStatusCB);
+
+    /** Set the network status acknowledgement.
+     *
+     * @param status The network status.
+     */
+    void setNetworkStatus(bool status);
+
+    /**
+     * Add the entry for the service account credentials and scope.
+     *
+     * @param config The pointer to SignerConfig structured data contains the authentication credentials.
+     * @return The entry index or -1 when the entry could not be added.
+     *
+     * @note The config should be existed as long as the entry was used.
+     *
+     */
+    int add(SignerConfig *config);
+
+    /**
+     * Remove all entries and free the shared resources.
+     *
+     */
+    void end();
+
+    /**
+     * Get the number of entries.
+     *
+     */
+    size_t size();
+
+    /**
+     * Process the token tasks of all entries in non-blocking mode.
+     *
+     * @param budget_us The time budget in microseconds for this call.
+     * @return Boolean of all entries ready state.
+     *
+     * @note Only one entry is processed at a time, the entry that has its token request in progress
+     * will be processed until its request was done before the next due entry.
+     * The entries that their tokens are still valid are not processed until their refresh time.
+     *
+     */
+    bool poll(uint32_t budget_us = 1000);
+
+    /**
+     * Check the token ready state of the entry.
+     *
+     * @param index The entry index.
+     * @return Boolean of ready state.
+     *
+     */
+    bool tokenReady(int index);
+
+    /**
+     * Get the access token of the entry.
+     *
+     * @param index The entry index.
+     * @return The pointer to access token or empty string when the token is not ready.
+     *
+     * @note The returned pointer remains valid until the next poll or refreshToken call which can
+     * replace the token, use tokenSnapshot(index, buf, size) to keep the token.
+     *
+     */
+    const char *tokenSnapshot(int index);
+
+    /**
+     * Copy the access token of the entry.
+     *
+     * @param index The entry index.
+     * @param buf The buffer to copy the null-terminated token to.
+     * @param size The buffer size, ESP_SIGNER_MAX_ACCESS_TOKEN_LENGTH + 1 for the complete token.
+     * @return The length of the copied token or 0 when the token is not ready.
+     *
+     */
+    size_t tokenSnapshot(int index, char *buf, size_t size);
+
+    /**
+     * Get the generated access token of the entry.
+     *
+     * @param index The entry index.
+     * @return String of OAuth2.0 access token.
+     *
+     */
+    String accessToken(int index);
+
+    /**
+     * Get the token status string of the entry.
+     *
+     * @param index The entry index.
+     * @return token status String.
+     *
+     */
+    String getTokenStatus(int index);
+
+    /**
+     * Get the token generation error string of the entry.
+     *
+     * @param index The entry index.
+     * @return token generation error String.
+     *
+     */
+    String getTokenError(int index);
+
+    /**
+     * Get the token expiration timestamp of the entry (seconds from midnight Jan 1, 1970).
+     *
+     * @param index The entry index.
+     * @return timestamp.
+     *
+     */
+    unsigned long getExpiredTimestamp(int index);
+
+    /**
+     * Refresh the access token of the entry.
+     *
+     * @param index The entry index.
+     *
+     */
+    void refreshToken(int index);
+
+protected:
+    std::vector<GAuth_OAuth2_Client *> clients;
+    /* the TCP client which shared by all entries */
+    GAuth_TCP_Client *tcpClient = nullptr;
+    MB_FS mbfs;
+    uint32_t mb_ts = 0;
+    uint32_t mb_ts_offset = 0;
+    /* the entry that its token request is in progress */
+    int active = -1;
+    /* the last processed entry, the due entries are processed in round-robin order */
+    int last = -1;
+    /* the last failure millis and the retry interval of the entries */
+    std::vector<unsigned long> retryMillis;
+    std::vector<unsigned long> retryInterval;
+
+    GAuth_OAuth2_Client *getClient(int index);
+    /* find the next due entry, the failed entry is skipped until its retry interval was passed */
+    int nextDueEntry();
+    /* update the retry interval of the entry after it was processed */
+    void updateRetry(int index);
+};
+
+#endif
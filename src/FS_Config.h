@@ -78,6 +78,9 @@ static SdFat sd_fat_fs;   // should declare as static here
 /* Enable NTP */
 #define ESP_SIGNER_ENABLE_NTP_TIME
 
+/* If not verify the Google API servers with the built-in Google root CA trust anchors */
+// #define ESP_SIGNER_DISABLE_GOOGLE_TRUST_ANCHORS
+
 /* If not use on-board WiFi */
 // #define ESP_SIGNER_DISABLE_ONBOARD_WIFI
 
@@ -32,6 +32,9 @@
 #include <Arduino.h>
 #include "mbfs/MB_MCU.h"
 #include "GAuth_OAuth2_Client.h"
+#if !defined(ESP_SIGNER_DISABLE_GOOGLE_TRUST_ANCHORS)
+#include "ESP_Signer_Google_TA.h"
+#endif
 
 GAuth_OAuth2_Client::GAuth_OAuth2_Client()
 {
@@ -53,13 +56,16 @@ void GAuth_OAuth2_Client::begin(esp_signer_gauth_cfg_t *cfg, MB_FS *mbfs, uint32
 void GAuth_OAuth2_Client::end()
 {
     freeJson();
+    freePrivateKey();
 #if defined(ESP_SIGNER_HAS_WIFIMULTI)
     if (multi)
         delete multi;
     multi = nullptr;
 #endif
-    if (tcpClient)
+    if (tcpClient && !sharedTCPClient)
         freeClient(&tcpClient);
+    else
+        tcpClient = nullptr;
 }
 
 void GAuth_OAuth2_Client::newClient(GAuth_TCP_Client **client)
@@ -124,11 +130,15 @@ bool GAuth_OAuth2_Client::parseSAFile()
         initJson();
 
         size_t len = res;
+        uint16_t crc = 0;
         char *buf = MemoryHelper::createBuffer<char *>(mbfs, len + 10);
         if (mbfs->available(mbfs_type config->service_account.json.storage_type))
         {
             if ((int)len == mbfs->read(mbfs_type config->service_account.json.storage_type, (uint8_t *)buf, len))
+            {
+                crc = Utils::calCRC((const uint8_t *)buf, len);
                 jsonPtr->setJsonData(buf);
+            }
         }
 
         mbfs->close(mbfs_type config->service_account.json.storage_type);
@@ -172,6 +182,8 @@ bool GAuth_OAuth2_Client::parseSAFile()
 
                 MemoryHelper::freeBuffer(mbfs, buf);
 
+                sa_file_crc = crc;
+
                 return true;
             }
         }
@@ -195,7 +207,7 @@ void GAuth_OAuth2_Client::clearServiceAccountCreds()
 
 bool GAuth_OAuth2_Client::serviceAccountCredsReady()
 {
-    return (strlen_P(config->service_account.data.private_key) > 0 || config->signer.pk.length() > 0) &&
+    return (strlen_P(config->service_account.data.private_key) > 0 || config->signer.pk.length() > 0 || rsa_key_ready) &&
            config->service_account.data.client_email.length() > 0 &&
            config->service_account.data.project_id.length() > 0;
 }
@@ -353,46 +365,9 @@ bool GAuth_OAuth2_Client::handleToken()
         // If it is the first step and no task is currently running
         if (!config->signer.tokenTaskRunning)
         {
-            if (config->signer.step == esp_signer_gauth_jwt_generation_step_begin)
-            {
-
-                bool use_sa_key_file = false, valid_key_file = false;
-                // If service account key json file assigned and no private key parsing data
-                if (config->service_account.json.path.length() > 0 && config->signer.pk.length() == 0)
-                {
-                    use_sa_key_file = true;
-                    // Parse the private key from service account json file
-                    valid_key_file = parseSAFile();
-                }
-
-                // Check the SA creds
-                if (!serviceAccountCredsReady())
-                {
-                    config->signer.tokens.status = esp_signer_token_status_error;
-                    if (use_sa_key_file && !valid_key_file)
-                    {
-                        errorToString(ESP_SIGNER_ERROR_SERVICE_ACCOUNT_JSON_FILE_PARSING_ERROR, config->signer.tokens.error.message);
-                        config->signer.tokens.error.code = ESP_SIGNER_ERROR_SERVICE_ACCOUNT_JSON_FILE_PARSING_ERROR;
-                    }
-                    else
-                    {
-                        errorToString(ESP_SIGNER_ERROR_MISSING_SERVICE_ACCOUNT_CREDENTIALS, config->signer.tokens.error.message);
-                        config->signer.tokens.error.code = ESP_SIGNER_ERROR_MISSING_SERVICE_ACCOUNT_CREDENTIALS;
-                    }
-                    sendTokenStatusCB();
-                    return false;
-                }
-
-                // If no token status set, set the states
-                if (config->signer.tokens.status != esp_signer_token_status_on_initialize)
-                {
-                    config->signer.tokens.status = esp_signer_token_status_on_initialize;
-                    config->signer.tokens.error.code = 0;
-                    config->signer.tokens.error.message.clear();
-                    config->internal.last_jwt_generation_error_cb_millis = 0;
-                    sendTokenStatusCB();
-                }
-            }
+            // Check the service account credentials and set the token status
+            if (config->signer.step == esp_signer_gauth_jwt_generation_step_begin && !beginTokenTask())
+                return false;
 
             // If service account creds are ready, set the token processing task started flag and run the task
             _token_processing_task_enable = true;
@@ -403,6 +378,51 @@ bool GAuth_OAuth2_Client::handleToken()
     return config->signer.tokens.status == esp_signer_token_status_ready;
 }
 
+bool GAuth_OAuth2_Client::beginTokenTask()
+{
+    bool use_sa_key_file = false, valid_key_file = false;
+    // If service account key json file assigned and no private key parsing data
+    // The file will not be read again when its private key was already decoded and cached,
+    // it is read again only after begin() or reset() was called.
+    if (config->service_account.json.path.length() > 0 && config->signer.pk.length() == 0 && !rsa_key_ready)
+    {
+        freePrivateKey();
+        use_sa_key_file = true;
+        // Parse the private key from service account json file
+        valid_key_file = parseSAFile();
+    }
+
+    // Check the SA creds
+    if (!serviceAccountCredsReady())
+    {
+        config->signer.tokens.status = esp_signer_token_status_error;
+        if (use_sa_key_file && !valid_key_file)
+        {
+            errorToString(ESP_SIGNER_ERROR_SERVICE_ACCOUNT_JSON_FILE_PARSING_ERROR, config->signer.tokens.error.message);
+            config->signer.tokens.error.code = ESP_SIGNER_ERROR_SERVICE_ACCOUNT_JSON_FILE_PARSING_ERROR;
+        }
+        else
+        {
+            errorToString(ESP_SIGNER_ERROR_MISSING_SERVICE_ACCOUNT_CREDENTIALS, config->signer.tokens.error.message);
+            config->signer.tokens.error.code = ESP_SIGNER_ERROR_MISSING_SERVICE_ACCOUNT_CREDENTIALS;
+        }
+        sendTokenStatusCB();
+        return false;
+    }
+
+    // If no token status set, set the states
+    if (config->signer.tokens.status != esp_signer_token_status_on_initialize)
+    {
+        config->signer.tokens.status = esp_signer_token_status_on_initialize;
+        config->signer.tokens.error.code = 0;
+        config->signer.tokens.error.message.clear();
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        sendTokenStatusCB();
+    }
+
+    return true;
+}
+
 void GAuth_OAuth2_Client::initJson()
 {
     if (!jsonPtr)
@@ -421,7 +441,7 @@ void GAuth_OAuth2_Client::freeJson()
     resultPtr = nullptr;
 }
 
-void GAuth_OAuth2_Client::tryGetTime()
+void GAuth_OAuth2_Client::tryGetTime(bool wait)
 {
 
     if (!tcpClient || config->internal.clock_rdy)
@@ -439,8 +459,137 @@ void GAuth_OAuth2_Client::tryGetTime()
             config->internal.clock_rdy = TimeHelper::clockReady(mb_ts, mb_ts_offset);
         }
     }
+    else if (useDateClock())
+        requestClock();
     else
-        TimeHelper::syncClock(mb_ts, mb_ts_offset, config->time_zone, config);
+        TimeHelper::syncClock(mb_ts, mb_ts_offset, config->time_zone, config, wait);
+}
+
+bool GAuth_OAuth2_Client::useDateClock()
+{
+#if defined(ESP_SIGNER_DISABLE_GOOGLE_TRUST_ANCHORS)
+    // The Date header of the server that was not verified can't be trusted, the NTP server is used
+    return false;
+#else
+    return config && config->http_date_clock;
+#endif
+}
+
+void GAuth_OAuth2_Client::requestClock()
+{
+    if (!beginClockRequest())
+        return;
+
+    // The connection is made with the request
+    if (!sendClockRequest())
+        return;
+
+    finishClockRequest(true);
+}
+
+bool GAuth_OAuth2_Client::beginClockRequest()
+{
+    if (config->internal.last_clock_request_millis > 0 &&
+        millis() - config->internal.last_clock_request_millis < ESP_SIGNER_TIME_SYNC_INTERVAL)
+        return false;
+
+    config->internal.last_clock_request_millis = millis();
+
+    if (!reconnect(tcpClient))
+        return false;
+
+    // The same host as the token request
+    MB_String host;
+    HttpHelper::addGAPIsHost(host, esp_signer_gauth_pgm_str_36 /* "www" */);
+
+    if (!tcpClient->connected() && !tcpClient->connecting())
+        setCert(tcpClient);
+
+    tcpClient->setBufferSizes(2048, 1024);
+    tcpClient->setDNSCacheTTL(config->dns_cache.ttl);
+    tcpClient->begin(host.c_str(), 443, &response_code);
+
+    return true;
+}
+
+bool GAuth_OAuth2_Client::sendClockRequest()
+{
+    size_t len = writeClockRequest(nullptr);
+
+    char *req = MemoryHelper::createBuffer<char *>(mbfs, len + 1);
+    if (!req)
+        return false;
+
+    writeClockRequest(req);
+    bool sent = tcpClient->write((uint8_t *)req, len) == len;
+    request_millis = millis();
+    MemoryHelper::freeBuffer(mbfs, req);
+
+    // The response can't be read without the complete request
+    if (!sent)
+        tcpClient->stop();
+
+    return sent;
+}
+
+void GAuth_OAuth2_Client::finishClockRequest(bool received)
+{
+    // Only the Date header is used, the body (not found page) is discarded
+    if (received)
+    {
+        int httpCode = 0;
+        handleResponse(tcpClient, httpCode, nullptr, nullptr, false);
+    }
+
+    // The server was verified by the trust anchors, the connection is kept for the token request
+    preconnected = tcpClient->connected();
+}
+
+void GAuth_OAuth2_Client::setCert(GAuth_TCP_Client *client)
+{
+#if !defined(ESP_SIGNER_DISABLE_GOOGLE_TRUST_ANCHORS)
+    client->setTrustAnchors(esp_signer_google_tas, ESP_SIGNER_GOOGLE_TA_NUM);
+
+    // The certificate validity is checked with the device time when it was set,
+    // otherwise the server is verified by the trust anchors only e.g. to set the clock from its Date header
+    bool clock_rdy = config && config->internal.clock_rdy;
+    client->setX509IgnoreTime(!clock_rdy);
+    if (clock_rdy)
+    {
+        client->setX509Time(getTime());
+        client->setPinCache(config->cert.pin_ttl);
+    }
+#else
+    client->setCACert(nullptr);
+#endif
+}
+
+size_t GAuth_OAuth2_Client::writeClockRequest(char *out)
+{
+    size_t n = HttpHelper::putRequestFirst(out, http_get);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_28 /* "/" */);
+    n += HttpHelper::putRequestLast(out ? out + n : nullptr, esp_signer_gauth_pgm_str_36 /* "www" */);
+    n += HttpHelper::putConnectionHeader(out ? out + n : nullptr, true);
+    n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_1 /* "\r\n" */);
+    return n;
+}
+
+void GAuth_OAuth2_Client::adjustClock(uint32_t date, unsigned long rtt)
+{
+    if (!useDateClock() || date < ESP_SIGNER_DEFAULT_TS)
+        return;
+
+    // The server time was truncated to the second when the response was sent after about half of the round trip time
+    uint32_t ts = date + (rtt / 2 + 500) / 1000;
+
+    config->internal.clock_skew = (int)(ts - (uint32_t)getTime());
+
+    // The difference within the Date header resolution is not corrected
+    if (config->internal.clock_rdy && config->internal.clock_skew >= -1 && config->internal.clock_skew <= 1)
+        return;
+
+    setTime(ts);
+    config->internal.clock_rdy = TimeHelper::clockReady(mb_ts, mb_ts_offset);
 }
 
 void GAuth_OAuth2_Client::tokenProcessingTask()
@@ -469,7 +618,7 @@ void GAuth_OAuth2_Client::tokenProcessingTask()
                 if (isSyncTimeOut())
                 {
                     config->signer.tokens.error.message.clear();
-                    if (_cli_type == esp_signer_client_type_internal_basic_client)
+                    if (_cli_type == esp_signer_client_type_internal_basic_client && !useDateClock())
                         setTokenError(ESP_SIGNER_ERROR_NTP_SYNC_TIMED_OUT);
                     else
                         setTokenError(ESP_SIGNER_ERROR_SYS_TIME_IS_NOT_READY);
@@ -505,13 +654,17 @@ void GAuth_OAuth2_Client::tokenProcessingTask()
             tryGetTime();
             config->internal.last_jwt_begin_step_millis = millis();
 
-            if (config->internal.clock_rdy)
+            // The valid token was restored from the cache file which ends the task
+            if (config->internal.clock_rdy && !loadTokenCache())
                 config->signer.step = esp_signer_gauth_jwt_generation_step_encode_header_payload;
         }
         // encode the JWT token
         else if (config->signer.step == esp_signer_gauth_jwt_generation_step_encode_header_payload)
         {
-            if (createJWT())
+            // the JWT token was already signed ahead of time
+            if (takePreSignedJWT())
+                config->signer.step = esp_signer_gauth_jwt_generation_step_exchange;
+            else if (createJWT())
                 config->signer.step = esp_signer_gauth_jwt_generation_step_sign;
         }
         // sign the JWT token
@@ -520,6 +673,14 @@ void GAuth_OAuth2_Client::tokenProcessingTask()
             if (createJWT())
                 config->signer.step = esp_signer_gauth_jwt_generation_step_exchange;
         }
+        // the self-signed JWT token is the access token, no token exchange
+        else if (config->signer.step == esp_signer_gauth_jwt_generation_step_exchange && config->signer.selfSigned)
+        {
+            useSelfSignedJWT();
+            config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+            _token_processing_task_enable = false;
+            ret = true;
+        }
         // sending JWT token requst for auth token
         else if (config->signer.step == esp_signer_gauth_jwt_generation_step_exchange)
         {
@@ -546,162 +707,404 @@ void GAuth_OAuth2_Client::tokenProcessingTask()
     config->signer.tokenTaskRunning = false;
 }
 
-bool GAuth_OAuth2_Client::refreshToken()
+bool GAuth_OAuth2_Client::poll(uint32_t budget_us)
 {
-
     if (!config)
         return false;
 
-    if (config->signer.tokens.status == esp_signer_token_status_on_request ||
-        config->signer.tokens.status == esp_signer_token_status_on_refresh ||
-        config->internal.processing)
-        return false;
+    unsigned long start = micros();
 
-    if (config->internal.refresh_token.length() == 0 && config->internal.auth_token.length() == 0)
-        return false;
+    // At least one step will be processed in every call, the next steps will be processed while the budget remains.
+    // The RSA signing and the TCP connection (with its DNS lookup) can not be sliced, each of them is processed
+    // as a single step. The SSL handshake is processed with the received records in every step.
+    while (pollStep() && micros() - start < budget_us)
+        Utils::idle();
 
-    if (!initClient(esp_signer_gauth_pgm_str_8 /* "securetoken" */, esp_signer_token_status_on_refresh))
+    return config->signer.tokens.status == esp_signer_token_status_ready;
+}
+
+bool GAuth_OAuth2_Client::pollStep()
+{
+    // return when the blocking task is currently running
+    if (config->signer.tokenTaskRunning)
         return false;
 
-    jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_9 /* "grantType" */), pgm2Str(esp_signer_gauth_pgm_str_10 /* "refresh_token" */));
-    jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_11 /* "refreshToken" */), config->internal.refresh_token.c_str());
+    switch (poll_state)
+    {
+    case esp_signer_gauth_poll_state_connect:
 
-    MB_String req;
-    HttpHelper::addRequestHeaderFirst(req, http_post);
+        // TCP connection, the handshake that was started ahead of time is continued
+        if (!tcpClient->connecting() && !tcpClient->connectAsync())
+        {
+            if (poll_clock_request)
+                return finishPollClockRequest(false);
+            return finishPollRequest(handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST));
+        }
 
-    req += esp_signer_gauth_pgm_str_12; // "/v1/token?Key=""
-    req += config->api_key;
-    HttpHelper::addRequestHeaderLast(req);
+        poll_state = esp_signer_gauth_poll_state_handshake;
+        return true;
 
-    HttpHelper::addGAPIsHostHeader(req, esp_signer_gauth_pgm_str_8 /* "securetoken" */);
-    HttpHelper::addUAHeader(req);
-    HttpHelper::addContentLengthHeader(req, strlen(jsonPtr->raw()));
-    HttpHelper::addContentTypeHeader(req, esp_signer_gauth_pgm_str_13 /* "application/json" */);
-    HttpHelper::addNewLine(req);
+    case esp_signer_gauth_poll_state_handshake:
+    {
+        // SSL handshake without waiting for the server
+        int ret = tcpClient->pollConnect();
 
-    req += jsonPtr->raw(); // {"grantType":"refresh_token","refreshToken":"<refresh token>"}
+        if (ret < 0)
+        {
+            if (poll_clock_request)
+                return finishPollClockRequest(false);
+            return finishPollRequest(handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST));
+        }
 
-    tcpClient->send(req.c_str());
+        if (ret == 0)
+            return false;
 
-    req.clear();
-    if (response_code < 0)
-        return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST);
+        poll_state = esp_signer_gauth_poll_state_send;
+        return true;
+    }
 
-    struct esp_signer_gauth_auth_token_error_t error;
+    case esp_signer_gauth_poll_state_send:
 
-    int httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
-    MB_String payload;
-    if (handleResponse(tcpClient, httpCode, payload))
-    {
-        if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_14 /* "error/code" */))
+        if (poll_clock_request)
         {
-            error.code = resultPtr->to<int>();
-            config->signer.tokens.status = esp_signer_token_status_error;
-
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_15 /* "error/message" */))
-                error.message = resultPtr->to<const char *>();
+            if (!sendClockRequest())
+                return finishPollClockRequest(false);
         }
+        else if (!sendTokenRequest(false))
+            return finishPollRequest(false);
 
-        config->signer.tokens.error = error;
-        tokenInfo.status = config->signer.tokens.status;
-        tokenInfo.error = config->signer.tokens.error;
-        config->internal.last_jwt_generation_error_cb_millis = 0;
-        if (error.code != 0)
-            sendTokenStatusCB();
+        poll_wait_millis = millis();
+        poll_state = esp_signer_gauth_poll_state_wait_response;
+        return true;
 
-        if (error.code == 0)
-        {
+    case esp_signer_gauth_poll_state_wait_response:
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_19 /* "expires_in" */))
-                getExpiration(resultPtr->to<const char *>());
+        // Check the incoming data without waiting
+        if (tcpClient->available() > 0)
+        {
+            poll_state = esp_signer_gauth_poll_state_read_response;
+            return true;
+        }
 
-            return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
+        if (!tcpClient->connected() || !reconnect(tcpClient, poll_wait_millis))
+        {
+            if (poll_clock_request)
+                return finishPollClockRequest(false);
+            return finishPollRequest(handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT));
         }
 
-        return handleTaskError(ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
-    }
+        return false;
 
-    return handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT, httpCode);
-}
+    case esp_signer_gauth_poll_state_read_response:
 
-void GAuth_OAuth2_Client::setTokenError(int code)
-{
-    if (code != 0)
-        config->signer.tokens.status = esp_signer_token_status_error;
-    else
-    {
-        config->signer.tokens.error.message.clear();
-        config->signer.tokens.status = esp_signer_token_status_ready;
-    }
+        if (poll_clock_request)
+            return finishPollClockRequest(true);
 
-    config->signer.tokens.error.code = code;
+        return finishPollRequest(receiveTokenResponse());
 
-    if (config->signer.tokens.error.message.length() == 0)
-    {
-        config->internal.processing = false;
-        errorToString(code, config->signer.tokens.error.message);
+    default:
+        break;
     }
-}
 
-bool GAuth_OAuth2_Client::handleTaskError(int code, int httpCode)
-{
-    // Close TCP connection and unlock used flag
-    tcpClient->stop();
-    config->internal.processing = false;
-
-    switch (code)
+    if (!isExpired())
     {
+        preSignJWT();
+        preConnect();
+        return false;
+    }
 
-    case ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST:
+    switch (config->signer.step)
+    {
+    case esp_signer_gauth_jwt_generation_step_begin:
 
-        // Show error based on connection status
-        config->signer.tokens.error.message.clear();
-        setTokenError(code);
-        config->internal.last_jwt_generation_error_cb_millis = 0;
-        sendTokenStatusCB();
-        break;
-    case ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT:
+        if (!beginTokenTask())
+            return false;
 
-        // Request time out?
-        if (httpCode == 0)
-        {
-            // Show error based on request time out
-            setTokenError(code);
-        }
-        else
+        if (!config->internal.clock_rdy)
         {
-            // Show error from response http code
-            errorToString(httpCode, config->signer.tokens.error.message);
-            setTokenError(httpCode);
-        }
+            if (readyToSync())
+            {
+                if (isSyncTimeOut())
+                {
+                    config->signer.tokens.error.message.clear();
+                    if (_cli_type == esp_signer_client_type_internal_basic_client && !useDateClock())
+                        setTokenError(ESP_SIGNER_ERROR_NTP_SYNC_TIMED_OUT);
+                    else
+                        setTokenError(ESP_SIGNER_ERROR_SYS_TIME_IS_NOT_READY);
+                    sendTokenStatusCB();
+                    config->signer.tokens.status = esp_signer_token_status_on_initialize;
+                    config->internal.last_jwt_generation_error_cb_millis = 0;
+                    // allow the NTP request to be sent again
+                    config->internal.ntp_requested = false;
+                }
 
-        config->internal.last_jwt_generation_error_cb_millis = 0;
-        sendTokenStatusCB();
+                config->internal.clock_synched = false;
+                reconnect();
+            }
 
-        break;
+            // The clock request is processed in the next steps without waiting for the server
+            if (tcpClient && tcpClient->type() != esp_signer_client_type_external_gsm_client && useDateClock())
+            {
+                if (!beginClockRequest())
+                    return false;
 
-    default:
-        break;
-    }
+                poll_clock_request = true;
+                poll_state = esp_signer_gauth_poll_state_connect;
+                return true;
+            }
 
-    // Free memory
-    tcpClient->stop();
-    freeJson();
+            // check time without waiting
+            tryGetTime(false);
 
-    // reset token processing state
-    if (code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY || code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_UNNOTIFY)
-    {
-        config->signer.tokens.error.message.clear();
-        config->signer.tokens.status = esp_signer_token_status_ready;
-        config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
-        config->internal.last_jwt_generation_error_cb_millis = 0;
-        if (code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY)
-            sendTokenStatusCB();
+            if (!config->internal.clock_rdy)
+                return false;
+        }
 
+        // The valid token was restored from the cache file
+        if (loadTokenCache())
+            return false;
+
+        config->signer.step = esp_signer_gauth_jwt_generation_step_encode_header_payload;
         return true;
-    }
 
-    return false;
+    case esp_signer_gauth_jwt_generation_step_encode_header_payload:
+
+        // the JWT token was already signed ahead of time
+        if (takePreSignedJWT())
+            config->signer.step = esp_signer_gauth_jwt_generation_step_exchange;
+        else if (createJWT())
+            config->signer.step = esp_signer_gauth_jwt_generation_step_sign;
+        else
+            return false;
+        return true;
+
+    case esp_signer_gauth_jwt_generation_step_sign:
+
+        if (!createJWT())
+        {
+            config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+            return false;
+        }
+
+        config->signer.step = esp_signer_gauth_jwt_generation_step_exchange;
+        return true;
+
+    case esp_signer_gauth_jwt_generation_step_exchange:
+
+        // the self-signed JWT token is the access token, no token exchange
+        if (config->signer.selfSigned)
+        {
+            useSelfSignedJWT();
+            config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+            return false;
+        }
+
+        if (!readyToRefresh() || !beginTokenRequest(false))
+            return false;
+
+        poll_state = esp_signer_gauth_poll_state_connect;
+        return true;
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+bool GAuth_OAuth2_Client::finishPollRequest(bool ret)
+{
+    poll_state = esp_signer_gauth_poll_state_idle;
+
+    // send error cb
+    if (!reconnect())
+        handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST);
+
+    // new JWT token is needed when the token was issued or the JWT token was already cleared
+    config->signer.step = ret || config->signer.tokens.jwt.length() == 0 ? esp_signer_gauth_jwt_generation_step_begin : esp_signer_gauth_jwt_generation_step_exchange;
+
+    return false;
+}
+
+bool GAuth_OAuth2_Client::finishPollClockRequest(bool received)
+{
+    poll_state = esp_signer_gauth_poll_state_idle;
+    poll_clock_request = false;
+
+    // The clock is set from the response, the token request is started from the begin step with the kept connection
+    finishClockRequest(received);
+
+    return false;
+}
+
+bool GAuth_OAuth2_Client::isBusy()
+{
+    return config && (poll_state != esp_signer_gauth_poll_state_idle || config->signer.step != esp_signer_gauth_jwt_generation_step_begin);
+}
+
+time_t GAuth_OAuth2_Client::nextDueTime()
+{
+    if (!config || isBusy() || config->signer.tokens.status != esp_signer_token_status_ready || config->signer.tokens.expires == 0)
+        return 0;
+
+    time_t due = config->signer.tokens.expires - config->signer.preRefreshSeconds;
+
+    unsigned long lead = 0;
+
+    // The next JWT token can be signed ahead of time within the lead time
+    if (config->signer.preSign && rsa_key_ready && presigned_jwt.length() == 0)
+        lead = ESP_SIGNER_PRE_SIGN_LEAD_SECONDS;
+
+    // The connection can be established ahead of time
+    if (!preconnected && config->signer.preConnectSeconds > lead)
+        lead = config->signer.preConnectSeconds;
+
+    due -= lead;
+
+    return due > 0 ? due : 0;
+}
+
+bool GAuth_OAuth2_Client::refreshToken()
+{
+
+    if (!config)
+        return false;
+
+    if (config->signer.tokens.status == esp_signer_token_status_on_request ||
+        config->signer.tokens.status == esp_signer_token_status_on_refresh ||
+        config->internal.processing)
+        return false;
+
+    if (config->internal.refresh_token.length() == 0 && config->internal.auth_token.length() == 0)
+        return false;
+
+    if (!initClient(esp_signer_gauth_pgm_str_8 /* "securetoken" */, esp_signer_token_status_on_refresh))
+        return false;
+
+    if (!sendRequest(true, true))
+        return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST);
+
+    struct esp_signer_gauth_auth_token_error_t error;
+    struct esp_signer_token_response_t resp;
+
+    int httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
+    bool complete = handleResponse(tcpClient, httpCode, TokenResponseHelper::parseBody, &resp);
+
+    if (complete && (resp.hasError || httpCode == ESP_SIGNER_ERROR_HTTP_CODE_OK))
+    {
+        if (resp.hasErrorCode)
+        {
+            error.code = resp.errorCode;
+            config->signer.tokens.status = esp_signer_token_status_error;
+            error.message = resp.errorMessage;
+        }
+
+        config->signer.tokens.error = error;
+        tokenInfo.status = config->signer.tokens.status;
+        tokenInfo.error = config->signer.tokens.error;
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        if (error.code != 0)
+            sendTokenStatusCB();
+
+        if (error.code == 0)
+        {
+            if (resp.expiresIn >= 0)
+                getExpiration(resp.expiresIn);
+
+            return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
+        }
+
+        return handleTaskError(ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
+    }
+
+    return handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT, httpCode);
+}
+
+void GAuth_OAuth2_Client::setTokenError(int code)
+{
+    if (code != 0)
+        config->signer.tokens.status = esp_signer_token_status_error;
+    else
+    {
+        config->signer.tokens.error.message.clear();
+        config->signer.tokens.status = esp_signer_token_status_ready;
+    }
+
+    config->signer.tokens.error.code = code;
+
+    if (config->signer.tokens.error.message.length() == 0)
+    {
+        config->internal.processing = false;
+        errorToString(code, config->signer.tokens.error.message);
+    }
+}
+
+bool GAuth_OAuth2_Client::handleTaskError(int code, int httpCode)
+{
+    // The connection can be kept alive when the response was completely read
+    bool keepAlive = config->signer.keepAlive &&
+                     (code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY || code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_UNNOTIFY ||
+                      code == ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
+
+    // Close TCP connection and unlock used flag
+    if (!keepAlive)
+        tcpClient->stop();
+    config->internal.processing = false;
+
+    switch (code)
+    {
+
+    case ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST:
+
+        // Show error based on connection status
+        config->signer.tokens.error.message.clear();
+        setTokenError(code);
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        sendTokenStatusCB();
+        break;
+    case ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT:
+
+        // Request time out?
+        if (httpCode == 0)
+        {
+            // Show error based on request time out
+            setTokenError(code);
+        }
+        else
+        {
+            // Show error from response http code
+            errorToString(httpCode, config->signer.tokens.error.message);
+            setTokenError(httpCode);
+        }
+
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        sendTokenStatusCB();
+
+        break;
+
+    default:
+        break;
+    }
+
+    // Free memory
+    if (!keepAlive)
+        tcpClient->stop();
+    freeJson();
+
+    // reset token processing state
+    if (code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY || code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_UNNOTIFY)
+    {
+        config->signer.tokens.error.message.clear();
+        config->signer.tokens.status = esp_signer_token_status_ready;
+        config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        if (code == ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY)
+            sendTokenStatusCB();
+
+        return true;
+    }
+
+    return false;
 }
 
 void GAuth_OAuth2_Client::sendTokenStatusCB()
@@ -714,101 +1117,98 @@ void GAuth_OAuth2_Client::sendTokenStatusCB()
         config->token_status_callback(tokenInfo);
 }
 
-bool GAuth_OAuth2_Client::handleResponse(GAuth_TCP_Client *client, int &httpCode, MB_String &payload, bool stopSession)
+bool GAuth_OAuth2_Client::handleResponse(GAuth_TCP_Client *client, int &httpCode, esp_signer_http_body_cb bodyCb, void *arg, bool stopSession)
+{
+    struct esp_signer_http_parser_t parser;
+    parser.bodyCb = bodyCb;
+    parser.arg = arg;
+
+    bool complete = handleResponse(client, parser, stopSession);
+    httpCode = parser.httpCode;
+    return complete;
+}
+
+bool GAuth_OAuth2_Client::handleResponse(GAuth_TCP_Client *client, esp_signer_http_parser_t &parser, bool stopSession)
 {
     if (!reconnect(client))
         return false;
 
-    MB_String header;
+    // The receive buffer is only needed when the data can't be borrowed from the TLS buffer
+    char *buf = nullptr;
 
-    struct esp_signer_server_response_data_t response;
-    struct esp_signer_tcp_response_handler_t tcpHandler;
+    // The round trip time is measured from the time the request was sent, the response of the request
+    // in non-blocking mode is read only after its data was available
+    unsigned long dataTime = millis(), requestTime = request_millis > 0 ? request_millis : dataTime, dateTime = 0;
 
-    HttpHelper::intTCPHandler(client, tcpHandler, 2048, 2048, nullptr);
-
-    while (client->connected() && client->available() == 0)
+    // Parse the available data in bulk, the body data is passed to the callback directly
+    while (!HttpParser::isComplete(parser) && !HttpParser::isError(parser))
     {
-        Utils::idle();
-        if (!reconnect(client, tcpHandler.dataTime))
-            return false;
-    }
-
-    bool complete = false;
+        // The decrypted data is parsed in the TLS buffer and released at once,
+        // the data after the end of the response is left in the connection
+        size_t peekLen = client->peekAvailable();
+        const char *peek = peekLen > 0 ? client->peekBuffer() : nullptr;
+        if (peek)
+        {
+            size_t consumed = HttpParser::parse(parser, peek, peekLen);
+            client->peekConsume(consumed);
 
-    tcpHandler.chunkBufSize = tcpHandler.defaultChunkSize;
+            // The response timeout is the idle time between the received data
+            if (consumed > 0)
+                dataTime = millis();
 
-    char *pChunk = MemoryHelper::createBuffer<char *>(mbfs, tcpHandler.chunkBufSize + 1);
+            if (parser.date > 0 && dateTime == 0)
+                dateTime = millis();
+            continue;
+        }
 
-    while (tcpHandler.available() || !complete)
-    {
-        Utils::idle();
+        int len = client->available();
 
-        if (!reconnect(client, tcpHandler.dataTime))
-            break;
+        if (len <= 0)
+        {
+            // The body without content length is ended when the server closed the connection
+            if (!client->connected())
+                break;
+
+            Utils::idle();
+            if (!reconnect(client, dataTime))
+                break;
+            continue;
+        }
 
-        if (!HttpHelper::readStatusLine(mbfs, client, tcpHandler, response))
+        if (!buf)
         {
-            // The next chunk data can be the remaining http header
-            if (tcpHandler.isHeader)
-            {
-                // Read header, complete?
-                if (HttpHelper::readHeader(mbfs, client, tcpHandler, response))
-                {
-                    if (response.httpCode == ESP_SIGNER_ERROR_HTTP_CODE_NO_CONTENT)
-                        tcpHandler.error.code = 0;
+            buf = MemoryHelper::createBuffer<char *>(mbfs, ESP_SIGNER_HTTP_RECEIVE_BUFFER_SIZE);
+            if (!buf)
+                break;
+        }
 
-                    if (Utils::isNoContent(&response))
-                        break;
-                }
-            }
-            else
-            {
-                memset(pChunk, 0, tcpHandler.chunkBufSize + 1);
-
-                // Read the avilable data
-                // chunk transfer encoding?
-                if (response.isChunkedEnc)
-                    tcpHandler.bufferAvailable = HttpHelper::readChunkedData(mbfs, client,
-                                                                             pChunk, nullptr, tcpHandler);
-                else
-                    tcpHandler.bufferAvailable = HttpHelper::readLine(client,
-                                                                      pChunk, tcpHandler.chunkBufSize);
-
-                if (tcpHandler.bufferAvailable > 0)
-                {
-                    tcpHandler.payloadRead += tcpHandler.bufferAvailable;
-                    payload += pChunk;
-                }
+        if (len > ESP_SIGNER_HTTP_RECEIVE_BUFFER_SIZE)
+            len = ESP_SIGNER_HTTP_RECEIVE_BUFFER_SIZE;
 
-                if (Utils::isChunkComplete(&tcpHandler, &response, complete) ||
-                    Utils::isResponseComplete(&tcpHandler, &response, complete))
-                {
+        len = client->read((uint8_t *)buf, len);
+        if (len > 0)
+        {
+            dataTime = millis();
+            HttpParser::parse(parser, buf, len);
 
-                    break;
-                }
-            }
+            if (parser.date > 0 && dateTime == 0)
+                dateTime = millis();
         }
     }
 
-    // To make sure all chunks read
-    if (response.isChunkedEnc)
-        client->flush();
+    MemoryHelper::freeBuffer(mbfs, buf);
 
-    MemoryHelper::freeBuffer(mbfs, pChunk);
-
-    if (stopSession && client->connected())
-        client->stop();
+    if (dateTime > 0)
+        adjustClock(parser.date, dateTime - requestTime);
 
-    httpCode = response.httpCode;
+    bool complete = HttpParser::isComplete(parser) || (HttpParser::isReadUntilClose(parser) && !client->connected());
 
-    if (jsonPtr && payload.length() > 0 && !response.noContent)
-    {
-        // Just a simple JSON which is suitable for parsing in low memory device
-        jsonPtr->setJsonData(payload.c_str());
-        return true;
-    }
+    // The server may close the connection even the keep-alive was requested,
+    // the incomplete response leaves the unread data in the connection which can't be reused
+    if ((stopSession || parser.connectionClose || !complete) && client->connected())
+        client->stop();
 
-    return httpCode == ESP_SIGNER_ERROR_HTTP_CODE_OK;
+    return complete;
 }
 
 bool GAuth_OAuth2_Client::createJWT()
@@ -821,156 +1221,531 @@ bool GAuth_OAuth2_Client::createJWT()
         config->internal.last_jwt_generation_error_cb_millis = 0;
         sendTokenStatusCB();
 
-        time_t now = getTime();
+        if (!encodeJWT(getTime()))
+        {
+            // The JWT token buffer could not be allocated
+            setTokenError(ESP_SIGNER_ERROR_TOKEN_SIGN);
+            sendTokenStatusCB();
+            return false;
+        }
+    }
+    else if (config->signer.step == esp_signer_gauth_jwt_generation_step_sign)
+    {
+        config->signer.tokens.status = esp_signer_token_status_on_signing;
 
-        initJson();
+        // RSA private key (decoded once and reused until the key was changed)
+        Utils::idle();
+        if (!loadPrivateKey())
+            return false;
 
-        config->signer.tokens.jwt.clear();
+        esp_signer_rsa_sign_backend backend = config->signer.rsaSignBackend;
 
-        // header
-        // {"alg":"RS256","typ":"JWT"}
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_20 /* "alg" */), pgm2Str(esp_signer_gauth_pgm_str_21 /* "RS256" */));
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_22 /* "typ" */), pgm2Str(esp_signer_gauth_pgm_str_23 /* "JWT" */));
+        // get the signed JWT
+        if (signJWT(backend) > 0)
+            config->signer.pk.clear();
+        else
+        {
+            setTokenError(ESP_SIGNER_ERROR_TOKEN_SIGN);
+            MB_String fn = (const char *)FPSTR("BearSSL, br_rsa_");
+            if (backend == esp_signer_rsa_sign_backend_i15)
+                fn += (const char *)FPSTR("i15");
+            else if (backend == esp_signer_rsa_sign_backend_i31)
+                fn += (const char *)FPSTR("i31");
+            else if (backend == esp_signer_rsa_sign_backend_i32)
+                fn += (const char *)FPSTR("i32");
+            else if (backend == esp_signer_rsa_sign_backend_i62)
+                fn += (const char *)FPSTR("i62");
+            fn += (const char *)FPSTR("_pkcs1_sign: ");
+            config->signer.tokens.error.message.insert(0, fn.c_str());
+            sendTokenStatusCB();
+            return false;
+        }
+    }
 
-        size_t len = Base64Helper::encodedLength(strlen(jsonPtr->raw()));
-        char *buf = MemoryHelper::createBuffer<char *>(mbfs, len);
-        Base64Helper::encodeUrl(mbfs, buf, (unsigned char *)jsonPtr->raw(), strlen(jsonPtr->raw()));
-        config->signer.encHeader = buf;
-        MemoryHelper::freeBuffer(mbfs, buf);
-        config->signer.encHeadPayload = config->signer.encHeader;
+    return true;
+}
 
-        // payload
-        // {"iss":"<email>","sub":"<email>","aud":"<audience>","iat":<timstamp>,"exp":<expire>,"scope":"<scope>"}
-        // {"iss":"<email>","sub":"<email>","aud":"<audience>","iat":<timstamp>,"exp":<expire>,"uid":"<uid>","claims":"<claims>"}
-        jsonPtr->clear();
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_24 /* "iss" */), config->service_account.data.client_email.c_str());
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_25 /* "sub" */), config->service_account.data.client_email.c_str());
+static void sha256Block(void *arg, const char *data, size_t len)
+{
+    br_sha256_update((br_sha256_context *)arg, data, len);
+}
 
-        MB_String t = esp_signer_gauth_pgm_str_26; // "https://"
-        HttpHelper::addGAPIsHost(t, esp_signer_gauth_pgm_str_27 /* "oauth2" */);
-        t += esp_signer_gauth_pgm_str_28; // "/"
-        t += esp_signer_gauth_pgm_str_29; // "token"
+size_t GAuth_OAuth2_Client::writeJWTHeader(char *out)
+{
+    // {"alg":"RS256","typ":"JWT","kid":"<private key id>"}
+    size_t n = JWTHelper::putChar(out, '{');
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_20 /* "alg" */, true);
+    n += JWTHelper::putStr(out ? out + n : nullptr, esp_signer_gauth_pgm_str_21 /* "RS256" */);
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_22 /* "typ" */, false);
+    n += JWTHelper::putStr(out ? out + n : nullptr, esp_signer_gauth_pgm_str_23 /* "JWT" */);
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_47 /* "kid" */, false);
+    n += JWTHelper::putStr(out ? out + n : nullptr, config->service_account.data.private_key_id.c_str());
+    n += JWTHelper::putChar(out ? out + n : nullptr, '}');
+    return n;
+}
 
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_30 /* "aud" */), t.c_str());
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_31 /* "iat" */), (int)now);
+size_t GAuth_OAuth2_Client::writeJWTClaims(char *out, time_t now)
+{
+    // {"iss":"<email>","sub":"<email>","aud":"<audience>","iat":<timstamp>,"exp":<expire>,"scope":"<scope>"}
+    // self-signed JWT
+    // {"iss":"<email>","sub":"<email>","aud":"<API endpoint>","iat":<timstamp>,"exp":<expire>}
+    // {"iss":"<email>","sub":"<email>","iat":<timstamp>,"exp":<expire>,"scope":"<scope>"}
+    size_t n = JWTHelper::putChar(out, '{');
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_24 /* "iss" */, true);
+    n += JWTHelper::putStr(out ? out + n : nullptr, config->service_account.data.client_email.c_str());
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_25 /* "sub" */, false);
+    n += JWTHelper::putStr(out ? out + n : nullptr, config->service_account.data.client_email.c_str());
+
+    bool addScope = true;
+
+    if (!config->signer.selfSigned)
+    {
+        // "https://oauth2.googleapis.com/token"
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_30 /* "aud" */, false);
+        n += JWTHelper::putChar(out ? out + n : nullptr, '"');
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_26 /* "https://" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_27 /* "oauth2" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_2 /* "." */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_pgm_str_3 /* "googleapis.com" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_28 /* "/" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_29 /* "token" */);
+        n += JWTHelper::putChar(out ? out + n : nullptr, '"');
+    }
+    else if (config->signer.tokens.audience.length() > 0)
+    {
+        // The audience and scope should not be used together
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_30 /* "aud" */, false);
+        n += JWTHelper::putStr(out ? out + n : nullptr, config->signer.tokens.audience.c_str());
+        addScope = false;
+    }
 
-        if (config->signer.expiredSeconds > 3600)
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_32 /* "exp" */), (int)(now + 3600));
-        else
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_32 /* "exp" */), (int)(now + config->signer.expiredSeconds));
+    unsigned long exp = config->signer.expiredSeconds > 3600 ? 3600 : config->signer.expiredSeconds;
 
-        MB_String s;
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_31 /* "iat" */, false);
+    n += JWTHelper::putInt(out ? out + n : nullptr, (uint32_t)now);
+    n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_32 /* "exp" */, false);
+    n += JWTHelper::putInt(out ? out + n : nullptr, (uint32_t)(now + exp));
 
+    if (addScope)
+    {
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_33 /* "scope" */, false);
         if (config->signer.tokens.scope.length() > 0)
-        {
-            std::vector<MB_String> scopes = std::vector<MB_String>();
-            StringHelper::splitTk(config->signer.tokens.scope, scopes, ",");
-            for (size_t i = 0; i < scopes.size(); i++)
-            {
-                if (s.length() > 0)
-                    s += esp_signer_pgm_str_15;
-                s += scopes[i];
-                scopes[i].clear();
-            }
-            scopes.clear();
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_33 /* "scope" */), s.c_str());
-        }
+            n += JWTHelper::putScope(out ? out + n : nullptr, config->signer.tokens.scope.c_str());
         else
-            jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_33 /* "scope" */), pgm2Str(esp_signer_gauth_pgm_str_46 /* "https://www.googleapis.com/auth/cloud-platform" */));
+            n += JWTHelper::putStr(out ? out + n : nullptr, esp_signer_gauth_pgm_str_46 /* "https://www.googleapis.com/auth/cloud-platform" */);
+    }
 
-        len = Base64Helper::encodedLength(strlen(jsonPtr->raw()));
-        buf = MemoryHelper::createBuffer<char *>(mbfs, len);
-        Base64Helper::encodeUrl(mbfs, buf, (unsigned char *)jsonPtr->raw(), strlen(jsonPtr->raw()));
-        config->signer.encPayload = buf;
-        MemoryHelper::freeBuffer(mbfs, buf);
+    n += JWTHelper::putChar(out ? out + n : nullptr, '}');
+    return n;
+}
 
-        config->signer.encHeadPayload += esp_signer_gauth_pgm_str_35; // "."
-        config->signer.encHeadPayload += config->signer.encPayload;
+bool GAuth_OAuth2_Client::encodeJWT(time_t now)
+{
+    MB_String &jwt = config->signer.tokens.jwt;
+
+    jwt_iat = now;
+
+    // The JWT token is built in a single buffer which sized for "<header>.<payload>.<signature>",
+    // the header and payload JSON are written at the tail of their encoded regions and Base64url
+    // encoded in place, the signature will be appended in the same way (see signJWT).
+
+    // The constant header {"alg":"RS256","typ":"JWT"} is pre-encoded, only the header with
+    // key id (self-signed JWT) should be encoded.
+    bool kid = config->signer.selfSigned && config->service_account.data.private_key_id.length() > 0;
+    size_t headerLen = kid ? writeJWTHeader(nullptr) : 0;
+    size_t encHeaderLen = kid ? Base64Helper::encodedUrlLength(headerLen) : strlen_P(esp_signer_gauth_pgm_str_48);
+    size_t payloadLen = writeJWTClaims(nullptr, now);
+    size_t encPayloadLen = Base64Helper::encodedUrlLength(payloadLen);
+    size_t headPayloadLen = encHeaderLen + 1 + encPayloadLen;
+    size_t len = headPayloadLen + 1 + Base64Helper::encodedUrlLength(config->signer.signatureSize);
+
+    // The existing buffer will be reused if it is large enough
+    jwt.reserve(len);
+    if (jwt.bufferLength() < len + 1)
+        return false;
 
-        config->signer.encHeader.clear();
-        config->signer.encPayload.clear();
+    char *buf = &jwt[0];
 
-        // create message digest from encoded header and payload
-        config->signer.hash = MemoryHelper::createBuffer<char *>(mbfs, config->signer.hashSize);
-        br_sha256_context mc;
-        br_sha256_init(&mc);
-        br_sha256_update(&mc, config->signer.encHeadPayload.c_str(), config->signer.encHeadPayload.length());
-        br_sha256_out(&mc, config->signer.hash);
+    // The message digest of the signing input is created in the same pass as the encoding,
+    // every encoded block is hashed right after it was written.
+    br_sha256_context mc;
+    br_sha256_init(&mc);
 
-        config->signer.tokens.jwt = config->signer.encHeadPayload;
-        config->signer.tokens.jwt += esp_signer_gauth_pgm_str_35; // "."
-        config->signer.encHeadPayload.clear();
+    if (kid)
+    {
+        writeJWTHeader(buf + encHeaderLen - headerLen);
+        Base64Helper::encodeUrlInPlace(buf, headerLen, sha256Block, &mc);
+    }
+    else
+    {
+        memcpy_P(buf, esp_signer_gauth_pgm_str_48, encHeaderLen);
+        br_sha256_update(&mc, buf, encHeaderLen);
+    }
 
-        freeJson();
+    buf[encHeaderLen] = '.';
+    br_sha256_update(&mc, buf + encHeaderLen, 1);
+
+    char *payload = buf + encHeaderLen + 1;
+    writeJWTClaims(payload + encPayloadLen - payloadLen, now);
+    Base64Helper::encodeUrlInPlace(payload, payloadLen, sha256Block, &mc);
+
+    br_sha256_out(&mc, jwt_hash);
+
+    buf[headPayloadLen] = '.';
+    buf[headPayloadLen + 1] = '\0';
+
+    return true;
+}
+
+int GAuth_OAuth2_Client::signJWT(esp_signer_rsa_sign_backend &backend)
+{
+    br_rsa_pkcs1_sign rsa_sign = getRSASigner(backend);
+
+    MB_String &jwt = config->signer.tokens.jwt;
+
+    // The signature size is the modulus size of the key
+    size_t sigLen = (rsa_key.n_bitlen + 7) / 8;
+    size_t offset = jwt.length();
+    size_t len = offset + Base64Helper::encodedUrlLength(sigLen);
+
+    if (offset == 0)
+        return 0;
+
+    if (jwt.bufferLength() < len + 1)
+        jwt.reserve(len);
+
+    if (jwt.bufferLength() < len + 1)
+        return 0;
+
+    char *buf = &jwt[0];
+
+    // generate RSA signature from private key and message digest at the tail of the JWT token buffer
+    unsigned char *sig = (unsigned char *)buf + len - sigLen;
+
+    Utils::idle();
+    int ret = rsa_sign(BR_HASH_OID_SHA256, jwt_hash, br_sha256_SIZE, &rsa_key, sig);
+    Utils::idle();
+
+    if (ret > 0)
+    {
+        Base64Helper::encodeUrlInPlace(buf + offset, sigLen);
+        buf[len] = '\0';
     }
-    else if (config->signer.step == esp_signer_gauth_jwt_generation_step_sign)
+    else
+        buf[offset] = '\0';
+
+    memset(jwt_hash, 0, sizeof(jwt_hash));
+
+    return ret;
+}
+
+void GAuth_OAuth2_Client::preSignJWT()
+{
+    // The key should be decoded and cached from the previous signing
+    if (!config->signer.preSign || !rsa_key_ready || presigned_jwt.length() > 0 ||
+        config->signer.tokenTaskRunning || config->signer.tokens.status != esp_signer_token_status_ready ||
+        config->signer.tokens.expires == 0)
+        return;
+
+    time_t now = getTime();
+
+    // Sign only within the lead time before the refresh, the JWT token should be valid at the exchange time
+    if ((unsigned long)now < ESP_SIGNER_DEFAULT_TS ||
+        now < (time_t)(config->signer.tokens.expires - config->signer.preRefreshSeconds - ESP_SIGNER_PRE_SIGN_LEAD_SECONDS))
+        return;
+
+    if (!encodeJWT(now))
+        return;
+
+    esp_signer_rsa_sign_backend backend = config->signer.rsaSignBackend;
+
+    // The error will be ignored, the JWT token will be signed again in the token processing task
+    if (signJWT(backend) > 0)
     {
-        config->signer.tokens.status = esp_signer_token_status_on_signing;
+        presigned_jwt = config->signer.tokens.jwt;
+        presigned_iat = now;
+        presigned_crc = claimsCRC();
+    }
 
-        // RSA private key
-        PrivateKey *pk = nullptr;
-        Utils::idle();
-        // parse priv key
-        if (config->signer.pk.length() > 0)
-            pk = new PrivateKey((const char *)config->signer.pk.c_str());
-        else if (strlen_P(config->service_account.data.private_key) > 0)
-            pk = new PrivateKey((const char *)config->service_account.data.private_key);
+    config->signer.tokens.jwt.clear();
+}
 
-        if (!pk)
-        {
-            setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
-            config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, PrivateKey: "));
-            sendTokenStatusCB();
-            return false;
-        }
+void GAuth_OAuth2_Client::preConnect()
+{
+    if (config->signer.preConnectSeconds == 0 || config->signer.selfSigned || config->signer.tokenTaskRunning ||
+        config->signer.tokens.status != esp_signer_token_status_ready || config->signer.tokens.expires == 0)
+        return;
+
+    // The handshake that was started ahead of time is processed without waiting for the server
+    if (tcpClient->connecting())
+    {
+        int ret = tcpClient->pollConnect();
+        if (ret != 0)
+            preconnected = ret > 0;
+        return;
+    }
+
+    // The connection is still open, otherwise it was closed by server and should be made again
+    if (preconnected && tcpClient->connected())
+        return;
+
+    preconnected = false;
+
+    time_t now = getTime();
+
+    if ((unsigned long)now < ESP_SIGNER_DEFAULT_TS ||
+        now < (time_t)(config->signer.tokens.expires - config->signer.preRefreshSeconds - config->signer.preConnectSeconds))
+        return;
+
+    if (preconnect_millis > 0 && millis() - preconnect_millis < ESP_SIGNER_PRE_CONNECT_RETRY_INTERVAL)
+        return;
+
+    preconnect_millis = millis();
+
+    if (!reconnect(tcpClient))
+        return;
+
+    // The same host as the token request
+    MB_String host;
+    HttpHelper::addGAPIsHost(host, esp_signer_gauth_pgm_str_36 /* "www" */);
+
+    if (!tcpClient->connected())
+        setCert(tcpClient);
+
+    tcpClient->setBufferSizes(2048, 1024);
+    tcpClient->setDNSCacheTTL(config->dns_cache.ttl);
+    tcpClient->begin(host.c_str(), 443, &response_code);
+
+    // The error will be ignored, the connection will be made again at the token request
+    Utils::idle();
+    if (tcpClient->connectAsync())
+        preconnected = tcpClient->connected();
+    Utils::idle();
+}
+
+bool GAuth_OAuth2_Client::takePreSignedJWT()
+{
+    if (presigned_jwt.length() == 0)
+        return false;
+
+    time_t now = getTime();
+
+    unsigned long exp = config->signer.expiredSeconds > 3600 ? 3600 : config->signer.expiredSeconds;
+
+    bool valid = now >= presigned_iat && (unsigned long)(now - presigned_iat) + 60 < exp &&
+                 presigned_crc == claimsCRC();
+
+    // The private key was changed?
+    if (valid && strlen_P(config->service_account.data.private_key) > 0)
+        valid = privateKeyCRC(config->service_account.data.private_key) == config->internal.priv_key_crc;
+
+    if (valid)
+    {
+        config->signer.tokens.jwt = presigned_jwt;
+        jwt_iat = presigned_iat;
+    }
+
+    presigned_jwt.clear();
+    presigned_iat = 0;
+
+    return valid;
+}
+
+bool GAuth_OAuth2_Client::useSelfSignedJWT()
+{
+    unsigned long exp = config->signer.expiredSeconds > 3600 ? 3600 : config->signer.expiredSeconds;
+
+    config->internal.auth_token = config->signer.tokens.jwt;
+    config->signer.tokens.jwt.clear();
+    config->signer.tokens.expires = jwt_iat + exp;
+    config->signer.tokens.last_millis = millis();
+
+    saveTokenCache();
+
+    return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
+}
+
+uint16_t GAuth_OAuth2_Client::claimsCRC()
+{
+    MB_String claims = config->service_account.data.client_email;
+    claims += config->signer.tokens.scope;
+    claims += config->signer.tokens.audience;
+    return Utils::calCRC(mbfs, claims.c_str());
+}
+
+bool GAuth_OAuth2_Client::loadPrivateKey()
+{
+    const char *pem = nullptr;
+
+    if (config->signer.pk.length() > 0)
+        pem = config->signer.pk.c_str();
+    else if (strlen_P(config->service_account.data.private_key) > 0)
+        pem = config->service_account.data.private_key;
+
+    // The private key from service account json file was already decoded and its PEM data was cleared
+    if (!pem && rsa_key_ready)
+        return true;
+
+    uint16_t crc = pem ? privateKeyCRC(pem) : 0;
+
+    if (rsa_key_ready && crc == config->internal.priv_key_crc)
+        return true;
+
+    freePrivateKey();
+
+    PrivateKey *pk = nullptr;
+
+    // parse priv key
+    if (pem)
+        pk = new PrivateKey(pem);
+
+    if (!pk)
+    {
+        setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
+        config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, PrivateKey: "));
+        sendTokenStatusCB();
+        return false;
+    }
+
+    if (!pk->isRSA())
+    {
+        setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
+        config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, isRSA: "));
+        sendTokenStatusCB();
+        delete pk;
+        pk = nullptr;
+        return false;
+    }
+
+    const br_rsa_private_key *key = pk->getRSA();
+
+    // Copy the CRT components into one buffer to keep them after the PrivateKey object was deleted
+    size_t len = key->plen + key->qlen + key->dplen + key->dqlen + key->iqlen;
+    rsa_key_buf = MemoryHelper::createBuffer<unsigned char *>(mbfs, len, false);
+
+    if (!rsa_key_buf)
+    {
+        setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
+        config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, PrivateKey: "));
+        sendTokenStatusCB();
+        delete pk;
+        pk = nullptr;
+        return false;
+    }
+
+    unsigned char *p = rsa_key_buf;
+
+    rsa_key.n_bitlen = key->n_bitlen;
+
+    memcpy(p, key->p, key->plen);
+    rsa_key.p = p;
+    rsa_key.plen = key->plen;
+    p += key->plen;
+
+    memcpy(p, key->q, key->qlen);
+    rsa_key.q = p;
+    rsa_key.qlen = key->qlen;
+    p += key->qlen;
+
+    memcpy(p, key->dp, key->dplen);
+    rsa_key.dp = p;
+    rsa_key.dplen = key->dplen;
+    p += key->dplen;
+
+    memcpy(p, key->dq, key->dqlen);
+    rsa_key.dq = p;
+    rsa_key.dqlen = key->dqlen;
+    p += key->dqlen;
+
+    memcpy(p, key->iq, key->iqlen);
+    rsa_key.iq = p;
+    rsa_key.iqlen = key->iqlen;
+
+    delete pk;
+    pk = nullptr;
+
+    config->internal.priv_key_crc = crc;
+    rsa_key_ready = true;
+
+    return true;
+}
 
-        if (!pk->isRSA())
-        {
-            setTokenError(ESP_SIGNER_ERROR_TOKEN_PARSE_PK);
-            config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, isRSA: "));
-            sendTokenStatusCB();
-            delete pk;
-            pk = nullptr;
-            return false;
-        }
+void GAuth_OAuth2_Client::freePrivateKey()
+{
+    if (rsa_key_buf)
+    {
+        // wipe the key material before releasing the memory
+        memset(rsa_key_buf, 0, rsa_key.plen + rsa_key.qlen + rsa_key.dplen + rsa_key.dqlen + rsa_key.iqlen);
+        MemoryHelper::freeBuffer(mbfs, rsa_key_buf);
+    }
+    rsa_key_buf = nullptr;
+    memset(&rsa_key, 0, sizeof(br_rsa_private_key));
+    rsa_key_ready = false;
 
-        const br_rsa_private_key *br_rsa_key = pk->getRSA();
+    // The pre-signed JWT was signed with this key
+    presigned_jwt.clear();
+    presigned_iat = 0;
+}
 
-        // generate RSA signature from private key and message digest
-        config->signer.signature = new unsigned char[config->signer.signatureSize];
+uint16_t GAuth_OAuth2_Client::privateKeyCRC(const char *pem)
+{
+    // Same CRC16 as MB_FS::calCRC but reads the data with pgm_read_byte
+    uint8_t x;
+    uint16_t crc = 0xFFFF;
 
-        Utils::idle();
-        int ret = br_rsa_i15_pkcs1_sign(BR_HASH_OID_SHA256, (const unsigned char *)config->signer.hash,
-                                        br_sha256_SIZE, br_rsa_key, config->signer.signature);
-        Utils::idle();
-        MemoryHelper::freeBuffer(mbfs, config->signer.hash);
+    size_t length = strlen_P(pem);
 
-        size_t len = Base64Helper::encodedLength(config->signer.signatureSize);
-        char *buf = MemoryHelper::createBuffer<char *>(mbfs, len);
-        Base64Helper::encodeUrl(mbfs, buf, config->signer.signature, config->signer.signatureSize);
-        config->signer.encSignature = buf;
-        MemoryHelper::freeBuffer(mbfs, buf);
-        MemoryHelper::freeBuffer(mbfs, config->signer.signature);
-        delete pk;
-        pk = nullptr;
+    for (size_t i = 0; i < length; i++)
+    {
+        x = crc >> 8 ^ pgm_read_byte(pem + i);
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((uint16_t)(x << 12)) ^ ((uint16_t)(x << 5)) ^ ((uint16_t)x);
+    }
+    return crc;
+}
 
-        // get the signed JWT
-        if (ret > 0)
-        {
-            config->signer.tokens.jwt += config->signer.encSignature;
-            config->signer.pk.clear();
-            config->signer.encSignature.clear();
-        }
-        else
-        {
-            setTokenError(ESP_SIGNER_ERROR_TOKEN_SIGN);
-            config->signer.tokens.error.message.insert(0, (const char *)FPSTR("BearSSL, br_rsa_i15_pkcs1_sign: "));
-            sendTokenStatusCB();
-            return false;
-        }
+br_rsa_pkcs1_sign GAuth_OAuth2_Client::getRSASigner(esp_signer_rsa_sign_backend &backend)
+{
+    br_rsa_pkcs1_sign rsa_sign = nullptr;
+
+    switch (backend)
+    {
+    case esp_signer_rsa_sign_backend_i15:
+        rsa_sign = &br_rsa_i15_pkcs1_sign;
+        break;
+    case esp_signer_rsa_sign_backend_i31:
+        rsa_sign = &br_rsa_i31_pkcs1_sign;
+        break;
+    case esp_signer_rsa_sign_backend_i32:
+        rsa_sign = &br_rsa_i32_pkcs1_sign;
+        break;
+    case esp_signer_rsa_sign_backend_i62:
+        // returns null when the 64x64->128 multiplication is not supported
+        rsa_sign = br_rsa_i62_pkcs1_sign_get();
+        break;
+    default:
+        break;
     }
 
-    return true;
+    if (rsa_sign)
+        return rsa_sign;
+
+#if defined(ESP8266) || defined(MB_ARDUINO_PICO)
+    // The ESP8266 (LX106) and RP2040 (Cortex-M0+) have no fast 32x32->64 multiplication
+    // which the 15-bit words implementation is the fastest.
+    backend = esp_signer_rsa_sign_backend_i15;
+    return &br_rsa_i15_pkcs1_sign;
+#else
+    // i62 on 64-bit platform, i15 on Cortex-M and i31 for others e.g. ESP32 (Xtensa LX6/LX7, RISC-V)
+    rsa_sign = br_rsa_pkcs1_sign_get_default();
+    if (rsa_sign == br_rsa_i62_pkcs1_sign_get())
+        backend = esp_signer_rsa_sign_backend_i62;
+    else if (rsa_sign == &br_rsa_i15_pkcs1_sign)
+        backend = esp_signer_rsa_sign_backend_i15;
+    else
+        backend = esp_signer_rsa_sign_backend_i31;
+    return rsa_sign;
+#endif
 }
 
 bool GAuth_OAuth2_Client::initClient(PGM_P subDomain, esp_signer_gauth_auth_token_status status)
@@ -989,15 +1764,21 @@ bool GAuth_OAuth2_Client::initClient(PGM_P subDomain, esp_signer_gauth_auth_toke
         sendTokenStatusCB();
     }
 
-    // stop the TCP session
-    tcpClient->stop();
+    // stop the TCP session unless it was kept alive from the previous request or connected ahead of time
+    if (!config->signer.keepAlive && !preconnected && !tcpClient->connecting())
+        tcpClient->stop();
+
+    preconnected = false;
 
-    tcpClient->setCACert(nullptr);
+    // The certificates of the handshake in progress can't be changed
+    if (!tcpClient->connected() && !tcpClient->connecting())
+        setCert(tcpClient);
 
     if (!reconnect(tcpClient))
         return false;
 
     tcpClient->setBufferSizes(2048, 1024);
+    tcpClient->setDNSCacheTTL(config->dns_cache.ttl);
 
     initJson();
 
@@ -1005,12 +1786,21 @@ bool GAuth_OAuth2_Client::initClient(PGM_P subDomain, esp_signer_gauth_auth_toke
     HttpHelper::addGAPIsHost(host, subDomain);
 
     Utils::idle();
+    // The kept alive connection to other host will be closed
     tcpClient->begin(host.c_str(), 443, &response_code);
 
     return true;
 }
 
 bool GAuth_OAuth2_Client::requestTokens(bool refresh)
+{
+    if (!beginTokenRequest(refresh) || !sendTokenRequest(refresh))
+        return false;
+
+    return receiveTokenResponse();
+}
+
+bool GAuth_OAuth2_Client::beginTokenRequest(bool refresh)
 {
     time_t now = getTime();
 
@@ -1023,71 +1813,149 @@ bool GAuth_OAuth2_Client::requestTokens(bool refresh)
     if (!initClient(esp_signer_gauth_pgm_str_36 /* "www" */, refresh ? esp_signer_token_status_on_refresh : esp_signer_token_status_on_request))
         return false;
 
-    MB_String req;
-    HttpHelper::addRequestHeaderFirst(req, http_post);
+    return true;
+}
+
+bool GAuth_OAuth2_Client::sendTokenRequest(bool refresh)
+{
+    if (!sendRequest(refresh, false))
+        return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST, response_code);
+
+    return true;
+}
+
+size_t GAuth_OAuth2_Client::writeTokenRequestBody(char *out, bool refresh, bool secureToken, bool skipJWT)
+{
+    size_t n = JWTHelper::putChar(out, '{');
 
-    if (refresh)
+    if (secureToken)
+    {
+        // {"grantType":"refresh_token","refreshToken":"<refresh token>"}
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_9 /* "grantType" */, true);
+        n += JWTHelper::putStr(out ? out + n : nullptr, esp_signer_gauth_pgm_str_10 /* "refresh_token" */);
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_11 /* "refreshToken" */, false);
+        n += JWTHelper::putStr(out ? out + n : nullptr, config->internal.refresh_token.c_str());
+    }
+    else if (refresh)
     {
         // {"client_id":"<client id>","client_secret":"<client secret>","grant_type":"refresh_token",
         // "refresh_token":"<refresh token>"}
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_7 /* "client_id" */), config->internal.client_id.c_str());
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_37 /* "client_secret" */), config->internal.client_secret.c_str());
-
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */), pgm2Str(esp_signer_gauth_pgm_str_10 /* "refresh_token" */));
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_18 /* "refresh_token" */), config->internal.refresh_token.c_str());
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_7 /* "client_id" */, true);
+        n += JWTHelper::putStr(out ? out + n : nullptr, config->internal.client_id.c_str());
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_37 /* "client_secret" */, false);
+        n += JWTHelper::putStr(out ? out + n : nullptr, config->internal.client_secret.c_str());
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_38 /* "grant_type" */, false);
+        n += JWTHelper::putStr(out ? out + n : nullptr, esp_signer_gauth_pgm_str_10 /* "refresh_token" */);
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_18 /* "refresh_token" */, false);
+        n += JWTHelper::putStr(out ? out + n : nullptr, config->internal.refresh_token.c_str());
     }
     else
     {
-
         // rfc 7523, JWT Bearer Token Grant Type Profile for OAuth 2.0
 
         // {"grant_type":"urn:ietf:params:oauth:grant-type:jwt-bearer","assertion":"<signed jwt token>"}
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_38 /* "grant_type" */),
-                     pgm2Str(esp_signer_gauth_pgm_str_39 /* "urn:ietf:params:oauth:grant-type:jwt-bearer" */));
-        jsonPtr->add(pgm2Str(esp_signer_gauth_pgm_str_40 /* "assertion" */), config->signer.tokens.jwt.c_str());
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_38 /* "grant_type" */, true);
+        n += JWTHelper::putStr(out ? out + n : nullptr, esp_signer_gauth_pgm_str_39 /* "urn:ietf:params:oauth:grant-type:jwt-bearer" */);
+        n += JWTHelper::putKey(out ? out + n : nullptr, esp_signer_gauth_pgm_str_40 /* "assertion" */, false);
+        // the base64url encoded JWT token has no character to escape
+        n += JWTHelper::putChar(out ? out + n : nullptr, '"');
+        // the JWT token and the rest of the body are sent from their own buffers
+        if (skipJWT)
+            return n;
+        n += HttpHelper::putText(out ? out + n : nullptr, config->signer.tokens.jwt.c_str());
+        n += JWTHelper::putChar(out ? out + n : nullptr, '"');
+    }
+
+    n += JWTHelper::putChar(out ? out + n : nullptr, '}');
+    return n;
+}
+
+size_t GAuth_OAuth2_Client::writeTokenRequest(char *out, bool refresh, bool secureToken, bool skipJWT)
+{
+    size_t bodyLen = writeTokenRequestBody(nullptr, refresh, secureToken, false);
+
+    size_t n = HttpHelper::putRequestFirst(out, http_post);
+
+    if (secureToken)
+    {
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_12 /* "/v1/token?Key=" */);
+        n += HttpHelper::putText(out ? out + n : nullptr, config->api_key.c_str());
+        n += HttpHelper::putRequestLast(out ? out + n : nullptr, esp_signer_gauth_pgm_str_8 /* "securetoken" */);
+    }
+    else
+    {
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_28 /* "/" */);
+        n += JWTHelper::putRaw(out ? out + n : nullptr, esp_signer_gauth_pgm_str_29 /* "token" */);
+        n += HttpHelper::putRequestLast(out ? out + n : nullptr, esp_signer_gauth_pgm_str_41 /* "oauth2" */);
+        n += HttpHelper::putConnectionHeader(out ? out + n : nullptr, config->signer.keepAlive);
     }
 
-    req += esp_signer_gauth_pgm_str_28; // "/"
-    req += esp_signer_gauth_pgm_str_29; // "token"
-    HttpHelper::addRequestHeaderLast(req);
-    HttpHelper::addGAPIsHostHeader(req, esp_signer_gauth_pgm_str_41 /* "oauth2" */);
+    n += HttpHelper::putContentHeaders(out ? out + n : nullptr, bodyLen, esp_signer_gauth_pgm_str_13 /* "application/json" */);
+    n += writeTokenRequestBody(out ? out + n : nullptr, refresh, secureToken, skipJWT);
+    return n;
+}
+
+bool GAuth_OAuth2_Client::sendRequest(bool refresh, bool secureToken)
+{
+    // Count the request size first and write the request to the exact size buffer, the signed JWT token
+    // is not copied, it is gathered with the request into the same TLS record
+    bool skipJWT = !refresh && !secureToken;
+    size_t len = writeTokenRequest(nullptr, refresh, secureToken, skipJWT);
+
+    char *req = MemoryHelper::createBuffer<char *>(mbfs, len + 1);
+    if (!req)
+    {
+        response_code = ESP_SIGNER_ERROR_TCP_ERROR_TOO_LESS_RAM;
+        return false;
+    }
 
-    HttpHelper::addUAHeader(req);
-    HttpHelper::addContentLengthHeader(req, strlen(jsonPtr->raw()));
-    HttpHelper::addContentTypeHeader(req, esp_signer_gauth_pgm_str_13 /* "application/json" */);
-    HttpHelper::addNewLine(req);
+    writeTokenRequest(req, refresh, secureToken, skipJWT);
 
-    req += jsonPtr->raw();
+    esp_ssl_client_segment segments[3] = {{req, len, false},
+                                          {config->signer.tokens.jwt.c_str(), config->signer.tokens.jwt.length(), false},
+                                          {esp_signer_gauth_pgm_str_51 /* "\"}" */, strlen_P(esp_signer_gauth_pgm_str_51), true}};
 
-    tcpClient->send(req.c_str());
+    size_t count = skipJWT ? 3 : 1;
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += segments[i].len;
 
-    req.clear();
+    int sent = tcpClient->writev(segments, count);
+    request_millis = millis();
 
-    if (response_code < 0)
-        return handleTaskError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_LOST, response_code);
+    MemoryHelper::freeBuffer(mbfs, req);
 
+    // The short write is the send error even the TCP client error was not set
+    if (sent != (int)total)
+        response_code = sent < 0 ? sent : ESP_SIGNER_ERROR_TCP_ERROR_STREAM_WRITE;
+
+    return response_code >= 0;
+}
+
+bool GAuth_OAuth2_Client::receiveTokenResponse()
+{
     struct esp_signer_gauth_auth_token_error_t error;
+    struct esp_signer_token_response_t resp;
+    // The access token is written to its final buffer while the response is received
+    resp.accessToken = &config->internal.auth_token;
 
     int httpCode = ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT;
-    MB_String payload;
-    if (handleResponse(tcpClient, httpCode, payload))
+    bool complete = handleResponse(tcpClient, httpCode, TokenResponseHelper::parseBody, &resp, !config->signer.keepAlive);
+
+    if (complete && (resp.hasError || httpCode == ESP_SIGNER_ERROR_HTTP_CODE_OK))
     {
         config->signer.tokens.jwt.clear();
-        if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_14 /* "error/code" */))
+        if (resp.hasErrorCode)
         {
-            error.code = resultPtr->to<int>();
+            error.code = resp.errorCode;
             config->signer.tokens.status = esp_signer_token_status_error;
-
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_15 /* "error/message" */))
-                error.message = resultPtr->to<const char *>();
+            error.message = resp.errorMessage;
         }
-        else if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_42 /* "error" */))
+        else if (resp.hasError)
         {
             error.code = -1;
             config->signer.tokens.status = esp_signer_token_status_error;
-
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_43 /* "error_description" */))
-                error.message = resultPtr->to<const char *>();
+            error.message = resp.errorDescription;
         }
 
         if (error.code != 0)
@@ -1106,36 +1974,425 @@ bool GAuth_OAuth2_Client::requestTokens(bool refresh)
 
         if (error.code == 0)
         {
+            if (resp.expiresIn >= 0)
+                getExpiration(resp.expiresIn);
 
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_44 /* "access_token" */))
-                config->internal.auth_token = resultPtr->to<const char *>();
-
-            if (JsonHelper::parse(jsonPtr, resultPtr, esp_signer_gauth_pgm_str_19 /* "expires_in" */))
-                getExpiration(resultPtr->to<const char *>());
+            saveTokenCache();
+            saveTLSSession();
+            saveDNSCache();
 
             return handleTaskError(ESP_SIGNER_ERROR_TOKEN_COMPLETE_NOTIFY);
         }
         return handleTaskError(ESP_SIGNER_ERROR_TOKEN_ERROR_UNNOTIFY);
     }
 
+    // The partially received access token can't be used
+    if (resp.hasAccessToken)
+    {
+        config->internal.auth_token.clear();
+        config->signer.tokens.expires = 0;
+    }
+
     return handleTaskError(ESP_SIGNER_ERROR_HTTP_CODE_REQUEST_TIMEOUT, httpCode);
 }
 
-void GAuth_OAuth2_Client::getExpiration(const char *exp)
+void GAuth_OAuth2_Client::getExpiration(int expiresIn)
 {
     time_t now = getTime();
     unsigned long ms = millis();
-    config->signer.tokens.expires = now + atoi(exp);
+    config->signer.tokens.expires = now + expiresIn;
     config->signer.tokens.last_millis = ms;
 }
 
+bool GAuth_OAuth2_Client::loadTokenCache()
+{
+    if (!config || config->token_cache.path.length() == 0 || token_cache_checked)
+        return false;
+
+    time_t now = getTime();
+
+    // The cached token expiry time can't be checked without the valid time
+    if ((unsigned long)now < ESP_SIGNER_DEFAULT_TS)
+        return false;
+
+    token_cache_checked = true;
+
+    size_t payloadLen = 0;
+    uint8_t *buf = readCacheFile(config->token_cache, "ESGC", payloadLen);
+
+    if (!buf)
+        return false;
+
+    bool ret = false;
+    uint8_t *payload = buf + ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE;
+
+    // payload: expires (4) + credentials crc (2) + access token
+    if (payloadLen > 6)
+    {
+        uint32_t expires = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+        uint16_t crc = payload[4] | (payload[5] << 8);
+
+        if (crc == tokenCacheCRC() && now < (time_t)(expires - config->signer.preRefreshSeconds))
+        {
+            config->internal.auth_token = (const char *)(payload + 6);
+            config->signer.tokens.expires = expires;
+            config->signer.tokens.last_millis = millis();
+            ret = true;
+        }
+    }
+
+    memset(buf, 0, ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + payloadLen);
+    MemoryHelper::freeBuffer(mbfs, buf);
+
+    if (ret)
+    {
+        config->signer.step = esp_signer_gauth_jwt_generation_step_begin;
+        config->signer.tokens.error.message.clear();
+        config->signer.tokens.error.code = 0;
+        config->signer.tokens.status = esp_signer_token_status_ready;
+        config->internal.last_jwt_generation_error_cb_millis = 0;
+        sendTokenStatusCB();
+    }
+
+    return ret;
+}
+
+void GAuth_OAuth2_Client::saveTokenCache()
+{
+    if (!config || config->token_cache.path.length() == 0)
+        return;
+
+    size_t tokenLen = config->internal.auth_token.length();
+    size_t payloadLen = 6 + tokenLen;
+
+    if (tokenLen == 0 || payloadLen > 0xffff)
+        return;
+
+    uint8_t *payload = MemoryHelper::createBuffer<uint8_t *>(mbfs, payloadLen);
+    if (!payload)
+        return;
+
+    uint32_t expires = config->signer.tokens.expires;
+    uint16_t crc = tokenCacheCRC();
+    payload[0] = expires & 0xff;
+    payload[1] = (expires >> 8) & 0xff;
+    payload[2] = (expires >> 16) & 0xff;
+    payload[3] = (expires >> 24) & 0xff;
+    payload[4] = crc & 0xff;
+    payload[5] = (crc >> 8) & 0xff;
+    memcpy(payload + 6, config->internal.auth_token.c_str(), tokenLen);
+
+    writeCacheFile(config->token_cache, "ESGC", payload, payloadLen);
+
+    memset(payload, 0, payloadLen);
+    MemoryHelper::freeBuffer(mbfs, payload);
+}
+
+uint16_t GAuth_OAuth2_Client::tokenCacheCRC()
+{
+    // The credentials content is used instead of its name, the token of the other service account which was
+    // replaced at the same file path is not restored. The file content crc was kept when the file was parsed.
+    uint16_t crc = 0;
+    if (config->service_account.json.path.length() > 0)
+        crc = sa_file_crc;
+    else
+    {
+        crc = config->service_account.data.private_key ? privateKeyCRC(config->service_account.data.private_key) : 0;
+        crc = Utils::calCRC((const uint8_t *)config->service_account.data.private_key_id.c_str(), config->service_account.data.private_key_id.length(), crc);
+        crc = Utils::calCRC((const uint8_t *)config->service_account.data.client_email.c_str(), config->service_account.data.client_email.length(), crc);
+    }
+
+    crc = Utils::calCRC((const uint8_t *)config->signer.tokens.scope.c_str(), config->signer.tokens.scope.length(), crc);
+    crc = Utils::calCRC((const uint8_t *)config->signer.tokens.audience.c_str(), config->signer.tokens.audience.length(), crc);
+    return crc;
+}
+
+bool GAuth_OAuth2_Client::loadTLSSession()
+{
+    if (!config || !tcpClient || config->tls_session_cache.path.length() == 0)
+        return false;
+
+    size_t payloadLen = 0;
+    uint8_t *buf = readCacheFile(config->tls_session_cache, "ESGS", payloadLen);
+
+    if (!buf)
+        return false;
+
+    bool ret = false;
+    uint8_t *payload = buf + ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE;
+
+    // payload: saved time (4) + host length (1) + host + session parameters
+    size_t hostLen = payloadLen > 5 ? payload[4] : 0;
+
+    if (hostLen > 0 && payloadLen == 5 + hostLen + ESP_SIGNER_TLS_SESSION_PARAMS_SIZE)
+    {
+        uint32_t ts = payload[0] | (payload[1] << 8) | (payload[2] << 16) | ((uint32_t)payload[3] << 24);
+        time_t now = getTime();
+
+        // The age can't be checked before the time was set, the server will do the full handshake if the session was expired
+        if ((unsigned long)now < ESP_SIGNER_DEFAULT_TS || (now >= (time_t)ts && now - ts < ESP_SIGNER_TLS_SESSION_MAX_AGE))
+        {
+            MB_String host;
+            host.append((const char *)payload + 5, hostLen);
+
+            uint8_t *p = payload + 5 + hostLen;
+            br_ssl_session_parameters *params = tcpClient->getSession(host.c_str())->getSession();
+
+            // The session that the shared TCP client already holds (e.g. restored by other pool entry) is kept
+            if (params->session_id_len == 0)
+            {
+                params->session_id_len = p[0] > sizeof(params->session_id) ? sizeof(params->session_id) : p[0];
+                memcpy(params->session_id, p + 1, sizeof(params->session_id));
+                params->version = p[33] | (p[34] << 8);
+                params->cipher_suite = p[35] | (p[36] << 8);
+                memcpy(params->master_secret, p + 37, sizeof(params->master_secret));
+
+                tls_session_crc = Utils::calCRC(p, ESP_SIGNER_TLS_SESSION_PARAMS_SIZE);
+                ret = true;
+            }
+        }
+    }
+
+    memset(buf, 0, ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + payloadLen);
+    MemoryHelper::freeBuffer(mbfs, buf);
+
+    return ret;
+}
+
+void GAuth_OAuth2_Client::saveTLSSession()
+{
+    if (!config || !tcpClient || config->tls_session_cache.path.length() == 0 || tcpClient->_host.length() == 0)
+        return;
+
+    size_t hostLen = tcpClient->_host.length();
+    if (hostLen > 0xff)
+        return;
+
+    size_t payloadLen = 5 + hostLen + ESP_SIGNER_TLS_SESSION_PARAMS_SIZE;
+    uint8_t *payload = MemoryHelper::createBuffer<uint8_t *>(mbfs, payloadLen);
+    if (!payload)
+        return;
+
+    uint32_t ts = getTime();
+    payload[0] = ts & 0xff;
+    payload[1] = (ts >> 8) & 0xff;
+    payload[2] = (ts >> 16) & 0xff;
+    payload[3] = (ts >> 24) & 0xff;
+    payload[4] = hostLen;
+    memcpy(payload + 5, tcpClient->_host.c_str(), hostLen);
+
+    // session id length (1) + session id (32) + version (2) + cipher suite (2) + master secret (48)
+    uint8_t *p = payload + 5 + hostLen;
+    br_ssl_session_parameters *params = tcpClient->getSession(tcpClient->_host.c_str())->getSession();
+    p[0] = params->session_id_len;
+    memcpy(p + 1, params->session_id, sizeof(params->session_id));
+    p[33] = params->version & 0xff;
+    p[34] = (params->version >> 8) & 0xff;
+    p[35] = params->cipher_suite & 0xff;
+    p[36] = (params->cipher_suite >> 8) & 0xff;
+    memcpy(p + 37, params->master_secret, sizeof(params->master_secret));
+
+    // Write only when the session was changed (full handshake) to reduce the flash wear
+    uint16_t crc = Utils::calCRC(p, ESP_SIGNER_TLS_SESSION_PARAMS_SIZE);
+
+    if (params->session_id_len > 0 && crc != tls_session_crc)
+    {
+        writeCacheFile(config->tls_session_cache, "ESGS", payload, payloadLen);
+        tls_session_crc = crc;
+    }
+
+    memset(payload, 0, payloadLen);
+    MemoryHelper::freeBuffer(mbfs, payload);
+}
+
+bool GAuth_OAuth2_Client::loadDNSCache()
+{
+    if (!config || !tcpClient || config->dns_cache.path.length() == 0)
+        return false;
+
+    size_t payloadLen = 0;
+    uint8_t *buf = readCacheFile(config->dns_cache, "ESGD", payloadLen);
+
+    if (!buf)
+        return false;
+
+    uint8_t *payload = buf + ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE;
+
+    // payload: count (1) + entries of host crc (2) + ip (4)
+    size_t count = payloadLen > 0 ? payload[0] : 0;
+    bool ret = count <= ESP_SIGNER_DNS_CACHE_SIZE && payloadLen == 1 + count * 6;
+
+    for (size_t i = 0; ret && i < count; i++)
+    {
+        uint8_t *p = payload + 1 + i * 6;
+        esp_signer_dns_cache_entry_t &entry = tcpClient->_dns_entries[i];
+        // The loaded addresses are stale, they will be used only when the host can't be resolved
+        entry.host_crc = p[0] | (p[1] << 8);
+        memcpy(entry.ip, p + 2, 4);
+        entry.fresh = false;
+    }
+
+    MemoryHelper::freeBuffer(mbfs, buf);
+
+    return ret;
+}
+
+void GAuth_OAuth2_Client::saveDNSCache()
+{
+    if (!config || !tcpClient || config->dns_cache.path.length() == 0 || !tcpClient->_dns_changed)
+        return;
+
+    uint8_t payload[1 + ESP_SIGNER_DNS_CACHE_SIZE * 6];
+    size_t count = 0;
+
+    for (int i = 0; i < ESP_SIGNER_DNS_CACHE_SIZE; i++)
+    {
+        esp_signer_dns_cache_entry_t &entry = tcpClient->_dns_entries[i];
+        if (entry.host_crc == 0)
+            continue;
+
+        uint8_t *p = payload + 1 + count * 6;
+        p[0] = entry.host_crc & 0xff;
+        p[1] = (entry.host_crc >> 8) & 0xff;
+        memcpy(p + 2, entry.ip, 4);
+        count++;
+    }
+
+    payload[0] = count;
+
+    writeCacheFile(config->dns_cache, "ESGD", payload, 1 + count * 6);
+    tcpClient->_dns_changed = false;
+}
+
+bool GAuth_OAuth2_Client::cacheKeyValid(esp_signer_gauth_token_cache_t &cache)
+{
+    return !cache.aes_key || cache.aes_key_len == 16 || cache.aes_key_len == 24 || cache.aes_key_len == 32;
+}
+
+uint8_t *GAuth_OAuth2_Client::readCacheFile(esp_signer_gauth_token_cache_t &cache, const char *magic, size_t &payloadLen)
+{
+    if (!cacheKeyValid(cache))
+        return nullptr;
+
+    int res = mbfs->open(cache.path, mbfs_type cache.storage_type, mb_fs_open_mode_read);
+
+    if (res < ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + 2)
+    {
+        if (res >= 0)
+            mbfs->close(mbfs_type cache.storage_type);
+        return nullptr;
+    }
+
+    size_t len = res;
+    uint8_t *buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, len + 1);
+    bool valid = false;
+
+    if (buf && (int)len == mbfs->read(mbfs_type cache.storage_type, buf, len))
+    {
+        bool encrypted = buf[5] & 1;
+        payloadLen = buf[6] | (buf[7] << 8);
+        size_t tagLen = encrypted ? ESP_SIGNER_TOKEN_CACHE_TAG_SIZE : 0;
+
+        // magic, version, size and crc check, the plain file is not accepted when the key was assigned
+        valid = memcmp(buf, magic, 4) == 0 && buf[4] == ESP_SIGNER_TOKEN_CACHE_VERSION &&
+                len == ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + payloadLen + tagLen + 2 &&
+                Utils::calCRC(buf, len - 2) == (uint16_t)(buf[len - 2] | (buf[len - 1] << 8)) &&
+                encrypted == (cache.aes_key != nullptr);
+
+        if (valid && encrypted)
+        {
+            uint8_t tag[ESP_SIGNER_TOKEN_CACHE_TAG_SIZE];
+            cacheCrypt(cache, buf + 8, buf, 8, buf + ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE, payloadLen, tag, false);
+            valid = Utils::equals(tag, buf + ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + payloadLen, ESP_SIGNER_TOKEN_CACHE_TAG_SIZE);
+        }
+    }
+
+    mbfs->close(mbfs_type cache.storage_type);
+
+    if (!valid)
+    {
+        if (buf)
+            memset(buf, 0, len);
+        MemoryHelper::freeBuffer(mbfs, buf);
+        return nullptr;
+    }
+
+    buf[ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + payloadLen] = 0;
+    return buf;
+}
+
+void GAuth_OAuth2_Client::writeCacheFile(esp_signer_gauth_token_cache_t &cache, const char *magic, const uint8_t *payload, size_t payloadLen)
+{
+    if (!cacheKeyValid(cache))
+        return;
+
+    bool encrypted = cache.aes_key != nullptr;
+    size_t tagLen = encrypted ? ESP_SIGNER_TOKEN_CACHE_TAG_SIZE : 0;
+    size_t len = ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE + payloadLen + tagLen + 2;
+
+    uint8_t *buf = MemoryHelper::createBuffer<uint8_t *>(mbfs, len);
+    if (!buf)
+        return;
+
+    // header: magic (4) + version (1) + flags (1) + payload length (2) + nonce (12)
+    memcpy(buf, magic, 4);
+    buf[4] = ESP_SIGNER_TOKEN_CACHE_VERSION;
+    buf[5] = encrypted ? 1 : 0;
+    buf[6] = payloadLen & 0xff;
+    buf[7] = (payloadLen >> 8) & 0xff;
+
+    uint8_t *p = buf + ESP_SIGNER_TOKEN_CACHE_HEADER_SIZE;
+    memcpy(p, payload, payloadLen);
+
+    if (encrypted)
+    {
+        Utils::randomBytes(buf + 8, 12);
+        cacheCrypt(cache, buf + 8, buf, 8, p, payloadLen, p + payloadLen, true);
+    }
+
+    uint16_t crc = Utils::calCRC(buf, len - 2);
+    buf[len - 2] = crc & 0xff;
+    buf[len - 1] = (crc >> 8) & 0xff;
+
+    if (mbfs->open(cache.path, mbfs_type cache.storage_type, mb_fs_open_mode_write) > -1)
+    {
+        mbfs->write(mbfs_type cache.storage_type, buf, len);
+        mbfs->close(mbfs_type cache.storage_type);
+    }
+
+    memset(buf, 0, len);
+    MemoryHelper::freeBuffer(mbfs, buf);
+}
+
+void GAuth_OAuth2_Client::cacheCrypt(esp_signer_gauth_token_cache_t &cache, const uint8_t *nonce, const uint8_t *aad, size_t aadLen, uint8_t *data, size_t len, uint8_t *tag, bool encrypt)
+{
+    br_aes_ct_ctr_keys aes;
+    br_gcm_context gcm;
+
+    br_aes_ct_ctr_init(&aes, cache.aes_key, cache.aes_key_len);
+    br_gcm_init(&gcm, &aes.vtable, br_ghash_ctmul32);
+    br_gcm_reset(&gcm, nonce, 12);
+    br_gcm_aad_inject(&gcm, aad, aadLen);
+    br_gcm_flip(&gcm);
+    br_gcm_run(&gcm, encrypt ? 1 : 0, data, len);
+    br_gcm_get_tag(&gcm, tag);
+
+    memset(&aes, 0, sizeof(aes));
+}
+
 void GAuth_OAuth2_Client::checkToken()
 {
-    if (!config)
+    // The token request is being processed in non-blocking mode
+    if (!config || poll_state != esp_signer_gauth_poll_state_idle)
         return;
 
     if (isExpired())
         handleToken();
+    else
+    {
+        preSignJWT();
+        preConnect();
+    }
 }
 
 bool GAuth_OAuth2_Client::tokenReady()
@@ -1249,6 +2506,15 @@ void GAuth_OAuth2_Client::reset()
         config->internal.email_crc = 0;
         config->internal.password_crc = 0;
 
+        freePrivateKey();
+        sa_file_crc = 0;
+        poll_state = esp_signer_gauth_poll_state_idle;
+        poll_clock_request = false;
+        request_millis = 0;
+        token_cache_checked = false;
+        preconnected = false;
+        preconnect_millis = 0;
+
         config->signer.tokens.status = esp_signer_token_status_uninitialized;
     }
 }
@@ -43,6 +43,8 @@
 class GAuth_OAuth2_Client
 {
     friend class ESP_Signer;
+    friend class SignerPool;
+    friend class AuthorizedClient;
 
 public:
     GAuth_OAuth2_Client();
@@ -51,6 +53,8 @@ public:
 private:
     GAuth_TCP_Client *tcpClient = nullptr;
     bool localTCPClient = false;
+    /* the TCP client is owned by the SignerPool */
+    bool sharedTCPClient = false;
     esp_signer_gauth_cfg_t *config = nullptr;
     MB_FS *mbfs = nullptr;
     uint32_t *mb_ts = nullptr;
@@ -79,6 +83,36 @@ private:
     void *_modem = nullptr;
 #endif
 
+    /* the decoded RSA private key which kept across the token refreshes */
+    br_rsa_private_key rsa_key;
+    /* the contiguous buffer that holds the RSA private key CRT components */
+    unsigned char *rsa_key_buf = nullptr;
+    bool rsa_key_ready = false;
+    /* the crc of service account json file content that the cached key was loaded from */
+    uint16_t sa_file_crc = 0;
+    /* the signed JWT token that was created ahead of time */
+    MB_String presigned_jwt;
+    time_t presigned_iat = 0;
+    /* the issued at time of the current JWT token */
+    time_t jwt_iat = 0;
+    /* the message digest of the encoded JWT header and payload */
+    unsigned char jwt_hash[br_sha256_SIZE];
+    uint16_t presigned_crc = 0;
+    /* the token request state in non-blocking (poll) mode */
+    esp_signer_gauth_poll_state poll_state = esp_signer_gauth_poll_state_idle;
+    unsigned long poll_wait_millis = 0;
+    /* the request in non-blocking mode is the clock request */
+    bool poll_clock_request = false;
+    /* the time when the last request was sent, the round trip time of the Date header is measured from it */
+    unsigned long request_millis = 0;
+    /* the token cache file was already checked after begin */
+    bool token_cache_checked = false;
+    /* the connection to the token server was established before the refresh time */
+    bool preconnected = false;
+    unsigned long preconnect_millis = 0;
+    /* the crc of the TLS session parameters that were saved or loaded */
+    uint16_t tls_session_crc = 0;
+
     /* intitialize the class */
     void begin(esp_signer_gauth_cfg_t *cfg, MB_FS *mbfs, uint32_t *mb_ts, uint32_t *mb_ts_offset);
     void end();
@@ -106,6 +140,8 @@ private:
     bool isErrorCBTimeOut();
     /* handle the auth tokens generation */
     bool handleToken();
+    /* check the service account credentials and set the token status at the beginning step */
+    bool beginTokenTask();
     /* init the temp use Json objects */
     void initJson();
     /* free the temp use Json objects */
@@ -116,20 +152,110 @@ private:
     void setTokenError(int code);
     /* handle the token processing task error */
     bool handleTaskError(int code, int httpCode = 0);
-    // parse the auth token response
-    bool handleResponse(GAuth_TCP_Client *client, int &httpCode, MB_String &payload, bool stopSession = true);
+    /* read and parse the response, the body data is passed to the callback while it is received, returns true when the response was completely read */
+    bool handleResponse(GAuth_TCP_Client *client, int &httpCode, esp_signer_http_body_cb bodyCb, void *arg, bool stopSession = true);
+    /* read and parse the response with the parser that was set up by the caller e.g. with its own body callback */
+    bool handleResponse(GAuth_TCP_Client *client, esp_signer_http_parser_t &parser, bool stopSession);
     /* Get time */
-    void tryGetTime();
+    void tryGetTime(bool wait = true);
+    /* the clock is set from the Date header of the server that was verified by the built-in trust anchors */
+    bool useDateClock();
+    /* send the request to the token server to set the clock from the Date header of its response */
+    void requestClock();
+    /* set up the connection of the clock request, returns false when it was requested within the sync interval */
+    bool beginClockRequest();
+    /* send the clock request, the connection is made when it was not connected */
+    bool sendClockRequest();
+    /* read the clock request response and keep the verified connection */
+    void finishClockRequest(bool received);
+    /* write the clock request or count its length when out is null */
+    size_t writeClockRequest(char *out);
+    /* set or adjust the clock from the response Date header and the round trip time in ms */
+    void adjustClock(uint32_t date, unsigned long rtt);
+    /* set the built-in Google trust anchors to verify the server, the certificate validity period is checked when the clock is ready */
+    void setCert(GAuth_TCP_Client *client);
     /* process the tokens (generation, signing, request and refresh) */
     void tokenProcessingTask();
+    /* process the token tasks step by step within the time budget in microseconds (non-blocking mode) */
+    bool poll(uint32_t budget_us);
+    /* process one token task step, returns false when no more step can be processed at this time */
+    bool pollStep();
+    /* reset the token request state in non-blocking mode and set the next JWT generation step */
+    bool finishPollRequest(bool ret);
+    /* reset the clock request state in non-blocking mode */
+    bool finishPollClockRequest(bool received);
+    /* the token request or JWT generation is in progress */
+    bool isBusy();
+    /* the time that the token task should be processed, returns 0 when it should be processed now */
+    time_t nextDueTime();
     /* encode and sign the JWT token */
     bool createJWT();
+    /* encode the JWT header and payload into the pre-sized JWT token buffer and create its message digest */
+    bool encodeJWT(time_t now);
+    /* write the JWT header JSON with key id or count its length when out is null */
+    size_t writeJWTHeader(char *out);
+    /* write the JWT claims JSON or count its length when out is null */
+    size_t writeJWTClaims(char *out, time_t now);
+    /* sign the message digest and append the signature to the JWT token */
+    int signJWT(esp_signer_rsa_sign_backend &backend);
+    /* create the next signed JWT token ahead of time while the current token is still valid */
+    void preSignJWT();
+    /* connect to the token server before the refresh time and keep the connection for the token request */
+    void preConnect();
+    /* use the pre-signed JWT token if it is still valid */
+    bool takePreSignedJWT();
+    /* use the signed JWT token as the access token (self-signed JWT mode) */
+    bool useSelfSignedJWT();
+    /* the JWT token claims crc to check whether the pre-signed JWT token is still usable */
+    uint16_t claimsCRC();
+    /* decode and cache the RSA private key, the cached key will be reused until the private key was changed */
+    bool loadPrivateKey();
+    /* free the cached RSA private key */
+    void freePrivateKey();
+    /* calculate the crc of private key which can be stored in flash memory (PROGMEM) */
+    uint16_t privateKeyCRC(const char *pem);
+    /* get the RSA signing function from the configured backend, the backend will be updated to the selected one */
+    br_rsa_pkcs1_sign getRSASigner(esp_signer_rsa_sign_backend &backend);
     /* request or refresh the token */
     bool requestTokens(bool refresh);
+    /* check the token request state and prepare the TCP client for the token request */
+    bool beginTokenRequest(bool refresh);
+    /* send the token request */
+    bool sendTokenRequest(bool refresh);
+    /* write the token request body JSON or count its length when out is null, skipJWT stops before the JWT token */
+    size_t writeTokenRequestBody(char *out, bool refresh, bool secureToken, bool skipJWT);
+    /* write the token request (or the Secure Token API refresh request) or count its length when out is null */
+    size_t writeTokenRequest(char *out, bool refresh, bool secureToken, bool skipJWT);
+    /* write the request to the exact size buffer and send it with the JWT token at once */
+    bool sendRequest(bool refresh, bool secureToken);
+    /* read and parse the token response */
+    bool receiveTokenResponse();
     /* check the token ready status and process the token tasks */
     void checkToken();
-    /* parse expiry time from string */
-    void getExpiration(const char *exp);
+    /* set expiry time from the token lifetime in seconds */
+    void getExpiration(int expiresIn);
+    /* restore the valid access token from the token cache file */
+    bool loadTokenCache();
+    /* save the access token to the token cache file */
+    void saveTokenCache();
+    /* the credentials content and scope crc to check whether the cached token belongs to the current config */
+    uint16_t tokenCacheCRC();
+    /* restore the saved TLS session parameters to resume the TLS session in the first connection */
+    bool loadTLSSession();
+    /* save the TLS session parameters of the current host when they were changed */
+    void saveTLSSession();
+    /* restore the saved host addresses which will be used when the host can't be resolved */
+    bool loadDNSCache();
+    /* save the resolved host addresses when they were changed */
+    void saveDNSCache();
+    /* the cache file is not used when the assigned AES key length is not 16, 24 or 32 bytes */
+    bool cacheKeyValid(esp_signer_gauth_token_cache_t &cache);
+    /* read, verify and decrypt the cache file, returns the buffer with payload at the header offset which should be freed */
+    uint8_t *readCacheFile(esp_signer_gauth_token_cache_t &cache, const char *magic, size_t &payloadLen);
+    /* encrypt (if the key was assigned) and write the payload to the cache file */
+    void writeCacheFile(esp_signer_gauth_token_cache_t &cache, const char *magic, const uint8_t *payload, size_t payloadLen);
+    /* encrypt or decrypt the cache data in place with AES-GCM */
+    void cacheCrypt(esp_signer_gauth_token_cache_t &cache, const uint8_t *nonce, const uint8_t *aad, size_t aadLen, uint8_t *data, size_t len, uint8_t *tag, bool encrypt);
     /* return error string from code */
     void errorToString(int httpCode, MB_String &buff);
     /* check the token ready status and process the token tasks and returns the status */
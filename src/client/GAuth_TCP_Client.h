@@ -64,6 +64,15 @@ typedef enum
 
 } esp_signer_client_type;
 
+struct esp_signer_dns_cache_entry_t
+{
+  uint16_t host_crc = 0;
+  uint8_t ip[4] = {0};
+  unsigned long resolved_millis = 0;
+  // the address was resolved after device started, the address that was loaded from file is used only as the fallback
+  bool fresh = false;
+};
+
 class GAuth_TCP_Client : public Client
 {
   friend class GAuth_OAuth2_Client;
@@ -143,6 +152,46 @@ public:
     }
   }
 
+  /**
+   * Set the trust anchors that were created at compile time to verify.
+   * @param ta The trust anchors.
+   * @param count The number of trust anchors.
+   */
+  void setTrustAnchors(const br_x509_trust_anchor *ta, size_t count)
+  {
+    // The anchors are used in place without decoding and copying
+    _tcp_client->setTrustAnchors(ta, count);
+
+    setCertType(esp_signer_cert_type_data);
+  }
+
+  /**
+   * Set the current time to check the certificate validity.
+   * @param now The current timestamp.
+   */
+  void setX509Time(time_t now)
+  {
+    _tcp_client->setX509Time(now);
+  }
+
+  /**
+   * Verify the certificate chain without its validity period when the time is unknown.
+   * @param ignore The ignore option.
+   */
+  void setX509IgnoreTime(bool ignore)
+  {
+    _tcp_client->setX509IgnoreTime(ignore);
+  }
+
+  /**
+   * Set the lifetime of the validated server certificate chain pin.
+   * @param ttl The pin lifetime in seconds, 0 to disable.
+   */
+  void setPinCache(uint32_t ttl)
+  {
+    _tcp_client->setPinCache(ttl);
+  }
+
   /**
    * Set Root CA certificate to verify.
    * @param certFile The certificate file path.
@@ -467,6 +516,10 @@ public:
    */
   bool begin(const char *host, uint16_t port, int *response_code)
   {
+    // The kept alive connection to other host can't be reused
+    if (connected() && (strcmp(_host.c_str(), host) != 0 || _port != port))
+      stop();
+
     _host = host;
     _port = port;
     _tcp_client->setBufferSizes(_rx_size, _tx_size);
@@ -499,12 +552,41 @@ public:
 
   bool connect()
   {
-    if (!_tcp_client)
+    // Wait for the handshake that was started by connectAsync, it's limited by the handshake timeout
+    if (_connecting)
+    {
+      int ret = 0;
+      while ((ret = pollConnect()) == 0)
+        delay(0);
+      return ret > 0;
+    }
+
+    if (!prepareConnect())
       return false;
 
-    _tcp_client->enableSSL(true);
+    if (connected())
+    {
+      flush();
+      return true;
+    }
 
-    _last_error = 0;
+    if (!_tcp_client->connect(_host.c_str(), _port))
+      return setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
+
+    return finishConnect();
+  }
+
+  /**
+   * Connect to the host and start the SSL handshake, the handshake is processed by pollConnect.
+   * @return true when the handshake was started or the connection was already made.
+   * @note The DNS lookup and the TCP connection are made in this call, they are limited by the TCP timeout.
+   */
+  bool connectAsync()
+  {
+    if (!prepareConnect())
+      return false;
+
+    _connecting = false;
 
     if (connected())
     {
@@ -512,6 +594,62 @@ public:
       return true;
     }
 
+    if (!_tcp_client->connectAsync(_host.c_str(), _port))
+    {
+      setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
+      return false;
+    }
+
+    _connecting = true;
+    return true;
+  }
+
+  /**
+   * Process the SSL handshake that was started by connectAsync without waiting for the server.
+   * @return 1 for connected, 0 for the handshake in progress or -1 for error.
+   */
+  int pollConnect()
+  {
+    if (!_connecting)
+      return connected() ? 1 : -1;
+
+    int ret = _tcp_client->pollConnect();
+    if (ret == 0)
+      return 0;
+
+    _connecting = false;
+
+    if (ret < 0)
+    {
+      setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
+      return -1;
+    }
+
+    return finishConnect() ? 1 : -1;
+  }
+
+  /**
+   * Get the status of the handshake that was started by connectAsync.
+   * @return true when the handshake is in progress.
+   */
+  bool connecting() { return _connecting; }
+
+  /**
+   * Prepare the basic client and the session for the new connection.
+   * @return true when the client is ready.
+   */
+  bool prepareConnect()
+  {
+    if (!_tcp_client)
+      return false;
+
+    _tcp_client->enableSSL(true);
+
+    _last_error = 0;
+
+    if (connected())
+      return true;
+
     if (!_basic_client)
     {
       if (_client_type == esp_signer_client_type_external_basic_client)
@@ -534,9 +672,32 @@ public:
 
     _tcp_client->setClient(_basic_client);
     _tcp_client->setDebugLevel(2);
-    if (!_tcp_client->connect(_host.c_str(), _port))
-      return setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
 
+#if defined(ESP_SIGNER_WIFI_IS_AVAILABLE)
+    // Connect to the cached address, the SSL client will use this connection for the same host.
+    // The connection to the other host is closed first and the SSL client takes this host for the new connection.
+    // The error will be ignored, the host will be resolved by the basic client.
+    IPAddress ip;
+    if (_dns_ttl > 0 && _client_type != esp_signer_client_type_external_gsm_client && !_connecting)
+    {
+      _tcp_client->validate(_host.c_str(), _port);
+      if (!_basic_client->connected() && resolveHost(_host.c_str(), ip))
+        _basic_client->connect(ip, _port);
+    }
+#endif
+
+    // Resume the TLS session with this host (abbreviated handshake) if its session parameters were kept
+    _tcp_client->setSession(getSession(_host.c_str()));
+
+    return true;
+  }
+
+  /**
+   * Set the options of the connection that was made.
+   * @return true when the connection is ready.
+   */
+  bool finishConnect()
+  {
 #if defined(ESP_SIGNER_WIFI_IS_AVAILABLE) && (defined(ESP32) || defined(ESP8266) || defined(MB_ARDUINO_PICO))
     if (_client_type == esp_signer_client_type_internal_basic_client)
       reinterpret_cast<BASE_WIFICLIENT *>(_basic_client)->setNoDelay(true);
@@ -587,6 +748,7 @@ public:
    */
   void stop()
   {
+    _connecting = false;
     if (_tcp_client)
       _tcp_client->stop();
   }
@@ -615,18 +777,42 @@ public:
     if (!_tcp_client->connected() && !connect())
       return setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
 
-    int toSend = _chunkSize;
-    int sent = 0;
-    while (sent < (int)size)
-    {
-      if (sent + toSend > (int)size)
-        toSend = size - sent;
+    // The SSL client fills the TLS record with the data directly, no need to split the data here
+    if (_tcp_client->write(data, size) != size)
+      return setError(ESP_SIGNER_ERROR_TCP_ERROR_SEND_REQUEST_FAILED);
+
+    setError(ESP_SIGNER_ERROR_HTTP_CODE_OK);
 
-      if ((int)_tcp_client->write(data + sent, toSend) != toSend)
-        return ESP_SIGNER_ERROR_TCP_ERROR_SEND_REQUEST_FAILED;
+    return size;
+  }
 
-      sent += toSend;
-    }
+  /**
+   * The TCP data gather write function.
+   * @param segments The data segments to write e.g. the request header, token and body.
+   * @param count The number of segments.
+   * @param records The optional number of TLS records that were sent.
+   * @return The size of data that was successfully written or negative number for error.
+   */
+  int writev(const esp_ssl_client_segment *segments, size_t count, size_t *records = nullptr)
+  {
+    if (!_tcp_client)
+      return setError(ESP_SIGNER_ERROR_TCP_CLIENT_NOT_INITIALIZED);
+
+    size_t size = 0;
+    for (size_t i = 0; segments && i < count; i++)
+      size += segments[i].len;
+
+    if (size == 0)
+      return setError(ESP_SIGNER_ERROR_TCP_ERROR_SEND_REQUEST_FAILED);
+
+    if (!networkReady())
+      return setError(ESP_SIGNER_ERROR_TCP_ERROR_NOT_CONNECTED);
+
+    if (!_tcp_client->connected() && !connect())
+      return setError(ESP_SIGNER_ERROR_TCP_ERROR_CONNECTION_REFUSED);
+
+    if (_tcp_client->writev(segments, count, records) != size)
+      return setError(ESP_SIGNER_ERROR_TCP_ERROR_SEND_REQUEST_FAILED);
 
     setError(ESP_SIGNER_ERROR_HTTP_CODE_OK);
 
@@ -706,6 +892,40 @@ public:
     return _tcp_client->available();
   }
 
+  /**
+   * Get the number of the received bytes that can be processed in place with peekBuffer.
+   * @return The number of bytes or 0 when the data can only be copied with read e.g. the plain connection.
+   */
+  size_t peekAvailable()
+  {
+    if (!_tcp_client)
+      return 0;
+
+    return _tcp_client->peekAvailable();
+  }
+
+  /**
+   * Borrow the decrypted data from the TLS receive buffer without copy.
+   * @return The data of peekAvailable bytes which is valid until peekConsume or read was called.
+   */
+  const char *peekBuffer()
+  {
+    if (!_tcp_client)
+      return nullptr;
+
+    return _tcp_client->peekBuffer();
+  }
+
+  /**
+   * Release the bytes of the peekBuffer data that were processed.
+   * @param len The number of bytes.
+   */
+  void peekConsume(size_t len)
+  {
+    if (_tcp_client)
+      _tcp_client->peekConsume(len);
+  }
+
   /**
    * The TCP data read function.
    * @return The read value or -1 for error.
@@ -958,6 +1178,94 @@ public:
     _tcp_client->setInsecure();
   }
 
+  /**
+   * Set the time to live of the resolved host addresses.
+   * @param ttl The seconds that the resolved address will be used without resolving again, 0 for disable.
+   */
+  void setDNSCacheTTL(unsigned long ttl) { _dns_ttl = ttl; }
+
+  /**
+   * Resolve the host address with the cache.
+   * The cached address will be used until its time to live was expired,
+   * the expired (stale) address will be used when the host can't be resolved.
+   * @param host The host name.
+   * @param ip The ip address result.
+   * @return true for success or false for failed.
+   */
+  bool resolveHost(const char *host, IPAddress &ip)
+  {
+    uint16_t crc = Utils::calCRC((const uint8_t *)host, strlen(host));
+    esp_signer_dns_cache_entry_t *entry = nullptr;
+
+    for (int i = 0; i < ESP_SIGNER_DNS_CACHE_SIZE; i++)
+    {
+      if (_dns_entries[i].host_crc == crc)
+      {
+        entry = &_dns_entries[i];
+        break;
+      }
+    }
+
+    if (entry && entry->fresh && millis() - entry->resolved_millis < _dns_ttl * 1000)
+    {
+      ip = IPAddress(entry->ip[0], entry->ip[1], entry->ip[2], entry->ip[3]);
+      return true;
+    }
+
+    if (hostByName(host, ip) == 1 && validIP(ip))
+    {
+      if (!entry)
+      {
+        entry = &_dns_entries[_dns_next];
+        _dns_next = (_dns_next + 1) % ESP_SIGNER_DNS_CACHE_SIZE;
+        entry->host_crc = crc;
+      }
+
+      bool changed = !entry->fresh;
+      for (int i = 0; i < 4; i++)
+      {
+        changed |= entry->ip[i] != ip[i];
+        entry->ip[i] = ip[i];
+      }
+
+      entry->fresh = true;
+      entry->resolved_millis = millis();
+      _dns_changed |= changed;
+      return true;
+    }
+
+    // Use the stale address when the resolver failed
+    if (entry)
+    {
+      ip = IPAddress(entry->ip[0], entry->ip[1], entry->ip[2], entry->ip[3]);
+      return true;
+    }
+
+    return false;
+  }
+
+  /**
+   * Get the TLS session of the host, the least recently assigned session will be reused for the new host.
+   * @param host The host name.
+   * @return The pointer to BearSSL_Session.
+   */
+  BearSSL_Session *getSession(const char *host)
+  {
+    uint16_t crc = Utils::calCRC((const uint8_t *)host, strlen(host));
+
+    for (int i = 0; i < ESP_SIGNER_TLS_SESSION_CACHE_SIZE; i++)
+    {
+      if (_session_hosts[i] == crc)
+        return &_sessions[i];
+    }
+
+    int i = _session_next;
+    _session_next = (_session_next + 1) % ESP_SIGNER_TLS_SESSION_CACHE_SIZE;
+    _session_hosts[i] = crc;
+    _sessions[i] = BearSSL_Session();
+    return &_sessions[i];
+  }
+
 private:
   // lwIP TCP Keepalive idle in seconds.
   int _tcpKeepIdleSeconds = -1;
@@ -970,6 +1278,18 @@ private:
   ESP_SSLClient *_tcp_client = nullptr;
   X509List *_x509 = nullptr;
 
+  // The resolved addresses of the recent hosts
+  esp_signer_dns_cache_entry_t _dns_entries[ESP_SIGNER_DNS_CACHE_SIZE];
+  int _dns_next = 0;
+  unsigned long _dns_ttl = 0;
+  // The resolved address was changed and should be saved
+  bool _dns_changed = false;
+
+  // The TLS session parameters of the recent hosts for the session resumption
+  BearSSL_Session _sessions[ESP_SIGNER_TLS_SESSION_CACHE_SIZE];
+  uint16_t _session_hosts[ESP_SIGNER_TLS_SESSION_CACHE_SIZE] = {0};
+  int _session_next = 0;
+
   MB_String _host;
   uint16_t _port = 443;
   IPAddress _ip;
@@ -988,8 +1308,9 @@ private:
   MB_String _pin, _apn, _user, _password;
   void *_modem = nullptr;
 #endif
-  int _chunkSize = 1024;
   bool _clock_ready = false;
+  // The SSL handshake was started by connectAsync and is not done
+  bool _connecting = false;
   int _last_error = 0;
   volatile bool _network_status = false;
   int _rx_size = 1024, _tx_size = 512;
@@ -17,6 +17,16 @@
 
 #define ESP_SSLCLIENT_VALID_TIMESTAMP 1690979919
 
+// The number of the servers that their validated certificate chains can be pinned
+#ifndef ESP_SSLCLIENT_PIN_CACHE_SIZE
+#define ESP_SSLCLIENT_PIN_CACHE_SIZE 4
+#endif
+
+// The minimum number of the trust anchors that are indexed by their DN hash
+#ifndef ESP_SSLCLIENT_TA_INDEX_MIN
+#define ESP_SSLCLIENT_TA_INDEX_MIN 4
+#endif
+
 #ifndef SSLCLIENT_CONNECTION_UPGRADABLE
 #define SSLCLIENT_CONNECTION_UPGRADABLE
 #endif
@@ -55,6 +65,14 @@ enum esp_ssl_client_error_types
     esp_ssl_internal_error
 };
 
+// The data segment of the gather write, the PROGMEM data is read with memcpy_P
+struct esp_ssl_client_segment
+{
+    const void *data;
+    size_t len;
+    bool pgm;
+};
+
 #if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
 
 static void esp_ssl_debug_print_prefix(const char *func_name, int level)
@@ -1205,6 +1205,25 @@ br_x509_minimal_run(void *t0ctx)
 			T0_CO();
 		}
 	}
+	if (CTX->trust_anchor_dynamic) {
+		const br_x509_trust_anchor *ta;
+		int ret;
+
+		ta = CTX->trust_anchor_dynamic(CTX->trust_anchor_dynamic_ctx,
+			CTX->saved_dn_hash, DNHASH_LEN);
+		if (ta) {
+			ret = (ta->flags & BR_X509_TA_CA)
+				? verify_signature(CTX, &ta->pkey) : -1;
+			if (CTX->trust_anchor_dynamic_free) {
+				CTX->trust_anchor_dynamic_free(
+					CTX->trust_anchor_dynamic_ctx, ta);
+			}
+			if (ret == 0) {
+				CTX->err = BR_ERR_X509_OK;
+				T0_CO();
+			}
+		}
+	}
 
 				}
 				break;
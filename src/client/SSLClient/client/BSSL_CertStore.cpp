@@ -32,6 +32,7 @@
 #if defined(ESP_SSL_FS_SUPPORTED)
 
 #include <memory>
+#include <algorithm>
 
 #if defined(DEBUG_ESP_SSL) && defined(DEBUG_ESP_PORT)
 #define DEBUG_BSSL(fmt, ...) DEBUG_ESP_PORT.printf_P((PGM_P)PSTR("BSSL:" fmt), ##__VA_ARGS__)
@@ -56,6 +57,20 @@ namespace bssl
   {
     free(_indexName);
     free(_dataName);
+    _clearCache();
+  }
+
+  void CertStore::setCacheSize(size_t size)
+  {
+    _clearCache();
+    _cacheSize = size;
+  }
+
+  void CertStore::_clearCache()
+  {
+    for (size_t i = 0; i < _cache.size(); i++)
+      delete _cache[i].x509;
+    _cache.clear();
   }
 
   CertStore::CertInfo CertStore::_preprocessCert(uint32_t length, uint32_t offset, const void *raw)
@@ -107,6 +122,7 @@ namespace bssl
     // In case initCertStore called multiple times, don't leak old filenames
     free(_indexName);
     free(_dataName);
+    _clearCache();
 
     // No strdup_P, so manually do it
     _indexName = (char *)malloc(strlen_P(indexFileName) + 1);
@@ -143,6 +159,9 @@ namespace bssl
     }
     offset += sizeof(magic);
 
+    // The index is written sorted by the DN hash for the binary search in findHashedTA
+    std::vector<CertStore::CertInfo> infos;
+
     while (true)
     {
       uint8_t fileHeader[60];
@@ -174,13 +193,7 @@ namespace bssl
       // If the filename starts with "//" then this is a rename file, skip it
       if (fileHeader[0] != '/' || fileHeader[1] != '/')
       {
-        CertStore::CertInfo ci = _preprocessCert(length, offset, raw);
-        if (index.write((uint8_t *)&ci, sizeof(ci)) != (ssize_t)sizeof(ci))
-        {
-          free(raw);
-          break;
-        }
-        count++;
+        infos.push_back(_preprocessCert(length, offset, raw));
       }
 
       offset += length;
@@ -193,6 +206,18 @@ namespace bssl
       }
     }
     data.close();
+
+    std::sort(infos.begin(), infos.end(), [](const CertStore::CertInfo &a, const CertStore::CertInfo &b)
+              { return memcmp(a.sha256, b.sha256, sizeof(a.sha256)) < 0; });
+
+    for (size_t i = 0; i < infos.size(); i++)
+    {
+      if (index.write((uint8_t *)&infos[i], sizeof(infos[i])) != (ssize_t)sizeof(infos[i]))
+      {
+        break;
+      }
+      count++;
+    }
     index.close();
     return count;
   }
@@ -212,57 +237,119 @@ namespace bssl
       return nullptr;
     }
 
+    // The recently used anchors are taken from the cache without reading the files
+    for (size_t i = 0; i < cs->_cache.size(); i++)
+    {
+      if (!memcmp(cs->_cache[i].sha256, hashed_dn, sizeof(ci.sha256)))
+      {
+        cs->_cache[i].used = ++cs->_cacheTick;
+        return cs->_cache[i].x509->getTrustAnchors();
+      }
+    }
+
     File index = cs->_fs->open(cs->_indexName, FILE_READ);
     if (!index)
     {
       return nullptr;
     }
 
-    while (index.read((uint8_t *)&ci, sizeof(ci)) == sizeof(ci))
+    bool found = false;
+    size_t lo = 0, hi = index.size() / sizeof(ci);
+    while (lo < hi)
     {
-      if (!memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256)))
+      size_t mid = lo + (hi - lo) / 2;
+      if (!index.seek(mid * sizeof(ci), SeekSet) || index.read((uint8_t *)&ci, sizeof(ci)) != sizeof(ci))
+      {
+        break;
+      }
+      int cmp = memcmp(ci.sha256, hashed_dn, sizeof(ci.sha256));
+      if (cmp == 0)
       {
-        index.close();
-        uint8_t *der = (uint8_t *)malloc(ci.length);
-        if (!der)
-        {
-          return nullptr;
-        }
-        File data = cs->_fs->open(cs->_dataName, FILE_READ);
-        if (!data)
-        {
-          free(der);
-          return nullptr;
-        }
-        if (!data.seek(ci.offset, SeekSet))
-        {
-          data.close();
-          free(der);
-          return nullptr;
-        }
-        if ((int)data.read(der, ci.length) != (int)ci.length)
-        {
-          free(der);
-          return nullptr;
-        }
-        data.close();
-        cs->_x509 = new (std::nothrow) X509List(der, ci.length);
-        free(der);
-        if (!cs->_x509)
-        {
-          DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
-          return nullptr;
-        }
-
-        br_x509_trust_anchor *ta = (br_x509_trust_anchor *)cs->_x509->getTrustAnchors();
-        memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
-        ta->dn.len = sizeof(ci.sha256);
-
-        return ta;
+        found = true;
+        break;
       }
+      if (cmp < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
     }
     index.close();
-    return nullptr;
+
+    if (!found)
+    {
+      return nullptr;
+    }
+
+    uint8_t *der = (uint8_t *)malloc(ci.length);
+    if (!der)
+    {
+      return nullptr;
+    }
+    File data = cs->_fs->open(cs->_dataName, FILE_READ);
+    if (!data)
+    {
+      free(der);
+      return nullptr;
+    }
+    if (!data.seek(ci.offset, SeekSet))
+    {
+      data.close();
+      free(der);
+      return nullptr;
+    }
+    if ((int)data.read(der, ci.length) != (int)ci.length)
+    {
+      data.close();
+      free(der);
+      return nullptr;
+    }
+    data.close();
+    X509List *x509 = new (std::nothrow) X509List(der, ci.length);
+    free(der);
+    if (!x509)
+    {
+      DEBUG_BSSL("CertStore::findHashedTA: OOM\n");
+      return nullptr;
+    }
+
+    br_x509_trust_anchor *ta = (br_x509_trust_anchor *)x509->getTrustAnchors();
+    if (!ta)
+    {
+      delete x509;
+      return nullptr;
+    }
+    memcpy(ta->dn.data, ci.sha256, sizeof(ci.sha256));
+    ta->dn.len = sizeof(ci.sha256);
+
+    if (cs->_cacheSize == 0)
+    {
+      // Freed in freeHashedTA
+      cs->_x509 = x509;
+      return ta;
+    }
+
+    // Replace the least recently used anchor when the cache is full
+    CertStore::CacheEntry entry;
+    memcpy(entry.sha256, ci.sha256, sizeof(ci.sha256));
+    entry.x509 = x509;
+    entry.used = ++cs->_cacheTick;
+    if (cs->_cache.size() < cs->_cacheSize)
+    {
+      cs->_cache.push_back(entry);
+    }
+    else
+    {
+      size_t lru = 0;
+      for (size_t i = 1; i < cs->_cache.size(); i++)
+      {
+        if (cs->_cache[i].used < cs->_cache[lru].used)
+          lru = i;
+      }
+      delete cs->_cache[lru].x509;
+      cs->_cache[lru] = entry;
+    }
+
+    return ta;
   }
 
   void CertStore::freeHashedTA(void *ctx, const br_x509_trust_anchor *ta)
@@ -40,6 +40,7 @@
 
 #include "../bssl/bearssl.h"
 #include "BSSL_Helper.h"
+#include <vector>
 
 using namespace bssl;
 
@@ -71,12 +72,29 @@ namespace bssl
     // Installs the cert store into the X509 decoder (normally via static function callbacks)
     void installCertStore(br_x509_minimal_context *ctx);
 
+    // Keep up to size recently used trust anchors decoded in RAM (0 to disable)
+    void setCacheSize(size_t size);
+
   protected:
     FS *_fs = nullptr;
     char *_indexName = nullptr;
     char *_dataName = nullptr;
     X509List *_x509 = nullptr;
 
+    // The decoded trust anchor and the tick of its last use
+    class CacheEntry
+    {
+    public:
+      uint8_t sha256[32];
+      X509List *x509;
+      uint32_t used;
+    };
+    std::vector<CacheEntry> _cache;
+    size_t _cacheSize = 0;
+    uint32_t _cacheTick = 0;
+
+    void _clearCache();
+
     // These need to be static as they are callbacks from BearSSL C code
     static const br_x509_trust_anchor *findHashedTA(void *ctx, void *hashed_dn, size_t len);
     static void freeHashedTA(void *ctx, const br_x509_trust_anchor *ta);
@@ -439,6 +439,347 @@ namespace bssl
             }
             return &xc->ctx.pkey;
         }
+
+        // The pin of the validated certificate chain, the same server certificate from the same server is accepted
+        // without verifying the chain signatures again until the pin was expired.
+        struct br_x509_pin
+        {
+            bool valid;
+            // SHA-256 of the server name, the server certificate and the server public key
+            uint8_t name_hash[32];
+            uint8_t cert_hash[32];
+            uint8_t spki_hash[32];
+            unsigned usages;
+            // The latest notBefore of the chain and the earliest of the chain notAfter and the pin expiry
+            uint32_t notbefore_days, notbefore_seconds;
+            uint32_t notafter_days, notafter_seconds;
+        };
+
+        // The x509 validator that checks the pinned server certificate by its fingerprint or passes the chain to
+        // x509_minimal for the full validation and pins the validated chain.
+        // The server certificate is always passed to x509_minimal, the pinned certificate that was changed
+        // is then fully validated with the rest of the chain in the same handshake.
+        // When the time is ignored, x509_minimal checks every certificate at the start of its own validity period,
+        // the chain is verified by the trust anchors and signatures only and is not pinned.
+        struct br_x509_pinned_context
+        {
+            const br_x509_class *vtable;
+            const br_x509_class **inner;
+            br_x509_pin *pins;
+            size_t pin_count;
+            uint32_t ttl;
+            uint32_t days, seconds;
+            bool ignore_time;
+            br_x509_pin *pin;
+            int cert_num;
+            uint8_t name_hash[32];
+            uint8_t cert_hash[32];
+            br_sha256_context sha256_cert;
+            uint32_t notbefore_days, notbefore_seconds;
+            uint32_t notafter_days, notafter_seconds;
+            br_x509_decoder_context ctx;
+        };
+
+        static int pinned_time_cmp(uint32_t days1, uint32_t seconds1, uint32_t days2, uint32_t seconds2)
+        {
+            if (days1 != days2)
+                return days1 < days2 ? -1 : 1;
+            if (seconds1 != seconds2)
+                return seconds1 < seconds2 ? -1 : 1;
+            return 0;
+        }
+
+        static void pinned_key_hash(const br_x509_pkey *pk, uint8_t *out)
+        {
+            br_sha256_context sha;
+            br_sha256_init(&sha);
+            br_sha256_update(&sha, &pk->key_type, 1);
+            if (pk->key_type == BR_KEYTYPE_RSA)
+            {
+                br_sha256_update(&sha, pk->key.rsa.n, pk->key.rsa.nlen);
+                br_sha256_update(&sha, pk->key.rsa.e, pk->key.rsa.elen);
+            }
+            else
+            {
+                uint8_t curve = pk->key.ec.curve;
+                br_sha256_update(&sha, &curve, 1);
+                br_sha256_update(&sha, pk->key.ec.q, pk->key.ec.qlen);
+            }
+            br_sha256_out(&sha, out);
+        }
+
+        // The certificates that x509_minimal should process, all of them in the full validation
+        // and only the server certificate when the chain was pinned.
+        static bool pinned_pass_through(const br_x509_pinned_context *xc)
+        {
+            return !xc->pin || xc->cert_num == 0;
+        }
+
+        static void pinned_start_chain(const br_x509_class **ctx, const char *server_name)
+        {
+            br_x509_pinned_context *xc = (br_x509_pinned_context *)ctx;
+
+            br_sha256_context sha;
+            br_sha256_init(&sha);
+            if (server_name)
+                br_sha256_update(&sha, server_name, strlen(server_name));
+            br_sha256_out(&sha, xc->name_hash);
+
+            br_sha256_init(&xc->sha256_cert);
+            xc->cert_num = 0;
+            xc->pin = nullptr;
+            xc->notbefore_days = 0;
+            xc->notbefore_seconds = 0;
+            xc->notafter_days = 0xFFFFFFFF;
+            xc->notafter_seconds = 0;
+
+            // The pin of this server is used when the current time is in its validity period
+            for (size_t i = 0; xc->days > 0 && i < xc->pin_count; i++)
+            {
+                br_x509_pin *pin = &xc->pins[i];
+                if (pin->valid && memcmp(pin->name_hash, xc->name_hash, sizeof(xc->name_hash)) == 0)
+                {
+                    if (pinned_time_cmp(xc->days, xc->seconds, pin->notbefore_days, pin->notbefore_seconds) >= 0 &&
+                        pinned_time_cmp(xc->days, xc->seconds, pin->notafter_days, pin->notafter_seconds) <= 0)
+                        xc->pin = pin;
+                    else
+                        pin->valid = false;
+                    break;
+                }
+            }
+
+            (*xc->inner)->start_chain(xc->inner, server_name);
+        }
+
+        static void pinned_start_cert(const br_x509_class **ctx, uint32_t length)
+        {
+            br_x509_pinned_context *xc = (br_x509_pinned_context *)ctx;
+
+            if (!pinned_pass_through(xc))
+                return;
+
+            // The certificate length is a part of the server certificate fingerprint
+            if (xc->cert_num == 0)
+            {
+                uint8_t len[4] = {(uint8_t)(length >> 24), (uint8_t)(length >> 16), (uint8_t)(length >> 8), (uint8_t)length};
+                br_sha256_update(&xc->sha256_cert, len, sizeof(len));
+            }
+
+            // Every certificate is decoded for its validity period in the full validation,
+            // the server certificate is also decoded for its public key when the chain was pinned
+#if defined(USE_EMBED_SSL_ENGINE)
+            br_x509_decoder_init(&xc->ctx, nullptr, nullptr, nullptr, nullptr);
+#elif defined(ESP32) || defined(USE_LIB_SSL_ENGINE)
+            br_x509_decoder_init(&xc->ctx, nullptr, nullptr);
+#endif
+
+            (*xc->inner)->start_cert(xc->inner, length);
+        }
+
+        static void pinned_append(const br_x509_class **ctx, const unsigned char *buf, size_t len)
+        {
+            br_x509_pinned_context *xc = (br_x509_pinned_context *)ctx;
+
+            if (!pinned_pass_through(xc))
+                return;
+
+            if (xc->cert_num == 0)
+                br_sha256_update(&xc->sha256_cert, buf, len);
+
+            // The decoder reads the validity period of the same data before x509_minimal checks it
+            br_x509_decoder_push(&xc->ctx, buf, len);
+
+            if (xc->ignore_time && xc->ctx.notbefore_days > 0)
+                br_x509_minimal_set_time((br_x509_minimal_context *)xc->inner, xc->ctx.notbefore_days, xc->ctx.notbefore_seconds);
+
+            (*xc->inner)->append(xc->inner, buf, len);
+        }
+
+        static void pinned_end_cert(const br_x509_class **ctx)
+        {
+            br_x509_pinned_context *xc = (br_x509_pinned_context *)ctx;
+
+            if (!pinned_pass_through(xc))
+            {
+                xc->cert_num++;
+                return;
+            }
+
+            if (xc->cert_num == 0)
+            {
+                br_sha256_out(&xc->sha256_cert, xc->cert_hash);
+
+                // The changed server certificate e.g. the renewed one, is fully validated with the rest of the chain
+                // as x509_minimal was already given this certificate
+                if (xc->pin)
+                {
+                    uint8_t spki_hash[32];
+                    const br_x509_pkey *pk = br_x509_decoder_get_pkey(&xc->ctx);
+                    if (pk)
+                        pinned_key_hash(pk, spki_hash);
+
+                    if (!pk || memcmp(xc->cert_hash, xc->pin->cert_hash, sizeof(xc->cert_hash)) != 0 ||
+                        memcmp(spki_hash, xc->pin->spki_hash, sizeof(spki_hash)) != 0)
+                    {
+                        xc->pin->valid = false;
+                        xc->pin = nullptr;
+                    }
+                }
+            }
+
+            if (br_x509_decoder_last_error(&xc->ctx) == 0)
+            {
+                if (pinned_time_cmp(xc->ctx.notbefore_days, xc->ctx.notbefore_seconds, xc->notbefore_days, xc->notbefore_seconds) > 0)
+                {
+                    xc->notbefore_days = xc->ctx.notbefore_days;
+                    xc->notbefore_seconds = xc->ctx.notbefore_seconds;
+                }
+                if (pinned_time_cmp(xc->ctx.notafter_days, xc->ctx.notafter_seconds, xc->notafter_days, xc->notafter_seconds) < 0)
+                {
+                    xc->notafter_days = xc->ctx.notafter_days;
+                    xc->notafter_seconds = xc->ctx.notafter_seconds;
+                }
+            }
+            else
+            {
+                // The chain that its validity period is unknown will not be pinned
+                xc->notafter_days = 0;
+            }
+
+            (*xc->inner)->end_cert(xc->inner);
+            xc->cert_num++;
+        }
+
+        static unsigned pinned_end_chain(const br_x509_class **ctx)
+        {
+            br_x509_pinned_context *xc = (br_x509_pinned_context *)ctx;
+
+            // The pinned server certificate was matched at its end
+            if (xc->pin)
+                return xc->cert_num > 0 ? 0 : BR_ERR_X509_EMPTY_CHAIN;
+
+            unsigned err = (*xc->inner)->end_chain(xc->inner);
+
+            if (err == 0 && xc->days > 0 &&
+                pinned_time_cmp(xc->days, xc->seconds, xc->notbefore_days, xc->notbefore_seconds) >= 0 &&
+                pinned_time_cmp(xc->days, xc->seconds, xc->notafter_days, xc->notafter_seconds) <= 0)
+            {
+                unsigned usages = 0;
+                const br_x509_pkey *pk = (*xc->inner)->get_pkey(xc->inner, &usages);
+                if (!pk)
+                    return err;
+
+                // Replace the pin of this server, the unused pin or the pin that expires first
+                br_x509_pin *pin = nullptr;
+                for (size_t i = 0; !pin && i < xc->pin_count; i++)
+                {
+                    if (xc->pins[i].valid && memcmp(xc->pins[i].name_hash, xc->name_hash, sizeof(xc->name_hash)) == 0)
+                        pin = &xc->pins[i];
+                }
+                for (size_t i = 0; !pin && i < xc->pin_count; i++)
+                {
+                    if (!xc->pins[i].valid)
+                        pin = &xc->pins[i];
+                }
+                if (!pin)
+                {
+                    pin = &xc->pins[0];
+                    for (size_t i = 1; i < xc->pin_count; i++)
+                    {
+                        if (pinned_time_cmp(xc->pins[i].notafter_days, xc->pins[i].notafter_seconds, pin->notafter_days, pin->notafter_seconds) < 0)
+                            pin = &xc->pins[i];
+                    }
+                }
+
+                memcpy(pin->name_hash, xc->name_hash, sizeof(xc->name_hash));
+                memcpy(pin->cert_hash, xc->cert_hash, sizeof(xc->cert_hash));
+                pinned_key_hash(pk, pin->spki_hash);
+                pin->usages = usages;
+                pin->notbefore_days = xc->notbefore_days;
+                pin->notbefore_seconds = xc->notbefore_seconds;
+
+                uint32_t seconds = xc->seconds + xc->ttl;
+                pin->notafter_days = xc->days + seconds / 86400;
+                pin->notafter_seconds = seconds % 86400;
+                if (pinned_time_cmp(xc->notafter_days, xc->notafter_seconds, pin->notafter_days, pin->notafter_seconds) < 0)
+                {
+                    pin->notafter_days = xc->notafter_days;
+                    pin->notafter_seconds = xc->notafter_seconds;
+                }
+                pin->valid = true;
+            }
+
+            return err;
+        }
+
+        static const br_x509_pkey *pinned_get_pkey(const br_x509_class *const *ctx, unsigned *usages)
+        {
+            br_x509_pinned_context *xc = (br_x509_pinned_context *)ctx;
+
+            if (!xc->pin)
+                return (*xc->inner)->get_pkey(xc->inner, usages);
+
+            if (usages != nullptr)
+                *usages = xc->pin->usages;
+            return br_x509_decoder_get_pkey(&xc->ctx);
+        }
+
+        // The CA trust anchor and the SHA-256 of its DN which is the same hash that x509_minimal
+        // uses for the issuer DN of the certificate.
+        struct br_x509_ta_index_entry
+        {
+            uint8_t dn_hash[32];
+            const br_x509_trust_anchor *ta;
+        };
+
+        // The trust anchors sorted by their DN hash which x509_minimal looks up with binary search
+        // through its dynamic trust anchor callbacks. The anchors that were not found are looked up
+        // from the cert store that was installed before the index.
+        struct br_x509_ta_index
+        {
+            const br_x509_ta_index_entry *entries;
+            size_t count;
+            const br_x509_trust_anchor *found;
+            void *next_ctx;
+            const br_x509_trust_anchor *(*next)(void *ctx, void *hashed_dn, size_t len);
+            void (*next_free)(void *ctx, const br_x509_trust_anchor *ta);
+        };
+
+        static const br_x509_trust_anchor *ta_index_find(void *ctx, void *hashed_dn, size_t len)
+        {
+            br_x509_ta_index *xi = (br_x509_ta_index *)ctx;
+            xi->found = nullptr;
+
+            if (len == sizeof(xi->entries->dn_hash))
+            {
+                size_t lo = 0, hi = xi->count;
+                while (lo < hi)
+                {
+                    size_t mid = lo + (hi - lo) / 2;
+                    int cmp = memcmp(xi->entries[mid].dn_hash, hashed_dn, len);
+                    if (cmp == 0)
+                    {
+                        xi->found = xi->entries[mid].ta;
+                        return xi->found;
+                    }
+                    if (cmp < 0)
+                        lo = mid + 1;
+                    else
+                        hi = mid;
+                }
+            }
+
+            return xi->next ? xi->next(xi->next_ctx, hashed_dn, len) : nullptr;
+        }
+
+        static void ta_index_free(void *ctx, const br_x509_trust_anchor *ta)
+        {
+            br_x509_ta_index *xi = (br_x509_ta_index *)ctx;
+            // The indexed anchors are owned by the client
+            if (ta != xi->found && xi->next_free)
+                xi->next_free(xi->next_ctx, ta);
+            xi->found = nullptr;
+        }
     }
 
 };
@@ -148,7 +148,7 @@ int BSSL_SSL_Client::connect(const char *host, uint16_t port)
 
 uint8_t BSSL_SSL_Client::connected()
 {
-    if (!mIsClientInitialized(false))
+    if (!mIsClientInitialized(false) || _handshake_pending)
         return 0;
 
     if (!_secure)
@@ -354,6 +354,130 @@ size_t BSSL_SSL_Client::write_P(PGM_P buf, size_t size)
     return write((const uint8_t *)dest, size);
 }
 
+// Gather the segments into the TLS records without the intermediate buffer, the record is
+// encrypted and sent when it is full or after the last segment
+size_t BSSL_SSL_Client::writev(const esp_ssl_client_segment *segments, size_t count, size_t *records)
+{
+    size_t total = 0;
+    size_t recs = 0;
+
+    if (records)
+        *records = 0;
+
+    if (!mIsClientInitialized(false) || !segments)
+        return 0;
+
+    if (!_secure)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const uint8_t *data = (const uint8_t *)segments[i].data;
+            size_t idx = 0;
+            while (idx < segments[i].len)
+            {
+                size_t sent = 0;
+                if (segments[i].pgm)
+                {
+                    // The flash data is copied through the small buffer
+                    uint8_t buf[64];
+                    size_t n = segments[i].len - idx > sizeof(buf) ? sizeof(buf) : segments[i].len - idx;
+                    memcpy_P(buf, data + idx, n);
+                    sent = _basic_client->write(buf, n);
+                }
+                else
+                    sent = _basic_client->write(data + idx, segments[i].len - idx);
+
+                if (sent == 0)
+                    return total;
+                idx += sent;
+                total += sent;
+            }
+        }
+        return total;
+    }
+
+    if (!mSoftConnected(__func__))
+        return 0;
+
+    // The data that was written before is kept in the unfinished record
+    if (!(br_ssl_engine_current_state(_eng) & BR_SSL_SENDAPP) && mRunUntil(BR_SSL_SENDAPP) < 0)
+    {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+        esp_ssl_debug_print(PSTR("Failed while waiting for the engine to enter BR_SSL_SENDAPP."), _debug_level, esp_ssl_debug_error, __func__);
+#endif
+        return 0;
+    }
+
+    size_t alen;
+    unsigned char *br_buf = br_ssl_engine_sendapp_buf(_eng, &alen);
+    if (alen == 0 || !br_buf)
+        return 0;
+
+    size_t pending = _write_idx;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint8_t *data = (const uint8_t *)segments[i].data;
+        size_t idx = 0;
+        while (idx < segments[i].len)
+        {
+            const size_t n = segments[i].len - idx >= alen - _write_idx ? alen - _write_idx : segments[i].len - idx;
+            if (segments[i].pgm)
+                memcpy_P(br_buf + _write_idx, data + idx, n);
+            else
+                memcpy(br_buf + _write_idx, data + idx, n);
+            _write_idx += n;
+            idx += n;
+            total += n;
+            pending += n;
+
+            // The full record is encrypted and sent
+            if (_write_idx == alen)
+            {
+                br_ssl_engine_sendapp_ack(_eng, _write_idx);
+                _write_idx = 0;
+                pending = 0;
+                recs++;
+                if (mRunUntil(BR_SSL_SENDAPP) < 0)
+                {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+                    esp_ssl_debug_print(PSTR("Failed while waiting for the engine to enter BR_SSL_SENDAPP."), _debug_level, esp_ssl_debug_error, __func__);
+#endif
+                    if (records)
+                        *records = recs;
+                    return 0;
+                }
+                br_buf = br_ssl_engine_sendapp_buf(_eng, &alen);
+                if (alen == 0 || !br_buf)
+                    return 0;
+            }
+        }
+    }
+
+    // The end of the data, the last record is sent now instead of waiting for the next read
+    if (pending > 0)
+    {
+        if (_write_idx > 0)
+            br_ssl_engine_sendapp_ack(_eng, _write_idx);
+        _write_idx = 0;
+        br_ssl_engine_flush(_eng, 0);
+        recs++;
+        if (mRunUntil(BR_SSL_SENDAPP) < 0)
+        {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+            esp_ssl_debug_print(PSTR("Failed while waiting for the engine to enter BR_SSL_SENDAPP."), _debug_level, esp_ssl_debug_error, __func__);
+#endif
+            if (records)
+                *records = recs;
+            return 0;
+        }
+    }
+
+    if (records)
+        *records = recs;
+    return total;
+}
+
 size_t BSSL_SSL_Client::write(Stream &stream)
 {
     if (!mIsClientInitialized(false))
@@ -435,6 +559,10 @@ int BSSL_SSL_Client::connectSSL(IPAddress ip, uint16_t port)
     if (!mIsClientInitialized(true))
         return 0;
 
+    // The connection of the unfinished handshake can't be reused
+    if (_handshake_pending)
+        stop();
+
     validate(ip, port);
 
     if (!_basic_client->connected() && !mConnectBasicClient(nullptr, ip, port))
@@ -452,6 +580,10 @@ int BSSL_SSL_Client::connectSSL(const char *host, uint16_t port)
     if (!mIsClientInitialized(true))
         return 0;
 
+    // The connection of the unfinished handshake can't be reused
+    if (_handshake_pending)
+        stop();
+
     validate(host, port);
 
     if (!_basic_client->connected() && !mConnectBasicClient(host, IPAddress(), port))
@@ -463,8 +595,87 @@ int BSSL_SSL_Client::connectSSL(const char *host, uint16_t port)
     return mConnectSSL(host);
 }
 
+int BSSL_SSL_Client::connectAsync(const char *host, uint16_t port)
+{
+    if (!_isSSLEnabled || !mIsSecurePort(port))
+        return connect(host, port);
+
+    if (!mIsClientInitialized(true))
+        return 0;
+
+    if (_handshake_pending)
+        stop();
+
+    validate(host, port);
+
+    if (!_basic_client->connected() && !mConnectBasicClient(host, IPAddress(), port))
+        return 0;
+
+    _host = host;
+    _port = port;
+
+    if (!mStartSSL(host))
+        return 0;
+
+    _handshake_pending = true;
+    _handshake_millis = millis();
+    return 1;
+}
+
+int BSSL_SSL_Client::pollConnect()
+{
+    if (!_handshake_pending)
+        return connected() ? 1 : -1;
+
+    // Only the records that were already received are processed, the server is not waited for
+    unsigned state = mUpdateEngine();
+
+    // The connection was stopped by the engine
+    if (!_handshake_pending)
+        return -1;
+
+    if (state == 0 || state == BR_SSL_CLOSED || getWriteError() != esp_ssl_ok)
+    {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+        esp_ssl_debug_print(PSTR("Failed to initlalize the SSL layer."), _debug_level, esp_ssl_debug_error, __func__);
+        if (_eng)
+            mPrintSSLError(br_ssl_engine_last_error(_eng), esp_ssl_debug_error, __func__);
+#endif
+        stop();
+        return -1;
+    }
+
+    if (state & BR_SSL_SENDAPP)
+    {
+        _handshake_pending = false;
+        _write_idx = 0;
+        return mFinishSSL();
+    }
+
+    if (millis() - _handshake_millis > (_handshake_timeout > 0 ? _handshake_timeout : getTimeout()))
+    {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+        esp_ssl_debug_print(PSTR("SSL internals timed out!"), _debug_level, esp_ssl_debug_error, __func__);
+#endif
+        setWriteError(esp_ssl_write_error);
+        stop();
+        return -1;
+    }
+
+    return 0;
+}
+
 void BSSL_SSL_Client::stop()
 {
+    // The connection of the unfinished handshake can't be used
+    if (_handshake_pending)
+    {
+        if (_basic_client)
+            _basic_client->stop();
+        mFreeSSL();
+        return;
+    }
+
     if (!_secure)
         return;
 
@@ -648,16 +859,62 @@ void BSSL_SSL_Client::allowSelfSignedCerts()
 // Install certificates of trusted CAs or specific site
 void BSSL_SSL_Client::setTrustAnchors(const X509List *ta)
 {
+    // The chains that were validated with other trust anchors can't be trusted
+    if (ta != _ta)
+    {
+        mClearPins();
+        mClearTAIndex();
+    }
     mClearAuthenticationSettings();
     _ta = ta;
 }
 
+// Install the trust anchors that were created at compile time, the anchors are used in place without copy
+void BSSL_SSL_Client::setTrustAnchors(const br_x509_trust_anchor *ta, size_t count)
+{
+    if (ta != _static_ta || count != _static_ta_count)
+    {
+        mClearPins();
+        mClearTAIndex();
+    }
+    mClearAuthenticationSettings();
+    _static_ta = ta;
+    _static_ta_count = count;
+}
+
 // In cases when NTP is not used, app must set a time manually to check cert validity
 void BSSL_SSL_Client::setX509Time(time_t now)
 {
     _now = now;
 }
 
+// Verify the chain by the trust anchors and signatures without its validity period when the time is unknown,
+// e.g. the server that the time is taken from
+void BSSL_SSL_Client::setX509IgnoreTime(bool ignore)
+{
+    _x509_ignore_time = ignore;
+}
+
+// Keep the pins of the fully validated certificate chains for ttl seconds (0 to disable),
+// the same server certificate from the same server is accepted by its fingerprint without verifying the chain signatures
+void BSSL_SSL_Client::setPinCache(uint32_t ttl)
+{
+    if (ttl == _pin_ttl)
+        return;
+
+    _pin_ttl = ttl;
+    if (ttl > 0)
+    {
+        _pins.resize(ESP_SSLCLIENT_PIN_CACHE_SIZE);
+        mClearPins();
+    }
+    else
+    {
+        _pins.clear();
+        _pins.shrink_to_fit();
+    }
+}
+
 void BSSL_SSL_Client::setClientRSACert(const X509List *chain, const PrivateKey *sk)
 {
     if (_esp32_chain)
@@ -997,6 +1254,9 @@ bool BSSL_SSL_Client::probeMaxFragmentLength(const String &host, uint16_t port,
 
 size_t BSSL_SSL_Client::peekAvailable()
 {
+    // The plain connection data is not kept in the engine buffer, it can only be read
+    if (!_secure)
+        return 0;
     return available();
 }
 
@@ -1004,12 +1264,18 @@ size_t BSSL_SSL_Client::peekAvailable()
 // semantic forbids any kind of read() before calling peekConsume()
 const char *BSSL_SSL_Client::peekBuffer()
 {
+    if (!_secure)
+        return nullptr;
     return (const char *)_recvapp_buf;
 }
 
 // consume bytes after use (see peekBuffer)
 void BSSL_SSL_Client::peekConsume(size_t consume)
 {
+    if (!_secure || !_recvapp_buf)
+        return;
+    if (consume > _recvapp_len)
+        consume = _recvapp_len;
     // according to BSSL_SSL_Client::read:
     br_ssl_engine_recvapp_ack(_eng, consume);
     _recvapp_buf = nullptr;
@@ -1020,6 +1286,7 @@ void BSSL_SSL_Client::setCACert(const char *rootCA)
 {
     if (_esp32_ta)
         delete _esp32_ta;
+    mClearTAIndex();
     _esp32_ta = new X509List(rootCA);
 }
 
@@ -1111,6 +1378,7 @@ void BSSL_SSL_Client::setSecure(const char *rootCABuff, const char *cli_cert, co
     {
         delete _esp32_ta;
         _esp32_ta = nullptr;
+        mClearTAIndex();
     }
     if (_esp32_chain)
     {
@@ -1442,6 +1710,29 @@ bool BSSL_SSL_Client::mSoftConnected(const char *func_name)
 }
 
 int BSSL_SSL_Client::mConnectSSL(const char *host)
+{
+    if (!mStartSSL(host))
+        return 0;
+
+// SSL/TLS handshake
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+    esp_ssl_debug_print(PSTR("Wait for SSL handshake."), _debug_level, esp_ssl_debug_info, __func__);
+#endif
+
+    if (mRunUntil(BR_SSL_SENDAPP, _handshake_timeout) < 0)
+    {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+        esp_ssl_debug_print(PSTR("Failed to initlalize the SSL layer."), _debug_level, esp_ssl_debug_error, __func__);
+        mPrintSSLError(br_ssl_engine_last_error(_eng), esp_ssl_debug_error, __func__);
+#endif
+        mFreeSSL();
+        return 0;
+    }
+
+    return mFinishSSL();
+}
+
+int BSSL_SSL_Client::mStartSSL(const char *host)
 {
 
 #if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
@@ -1457,7 +1748,7 @@ int BSSL_SSL_Client::mConnectSSL(const char *host)
 #else
 #define CRTSTORECOND
 #endif
-    if (!_use_insecure && !_use_fingerprint && !_use_self_signed && !_knownkey CRTSTORECOND && !_ta)
+    if (!_use_insecure && !_use_fingerprint && !_use_self_signed && !_knownkey CRTSTORECOND && !_ta && !_static_ta)
     {
         esp_ssl_debug_print(PSTR("Connection *will* fail, no authentication method is setup."), _debug_level, esp_ssl_debug_warn, __func__);
     }
@@ -1557,21 +1848,11 @@ int BSSL_SSL_Client::mConnectSSL(const char *host)
         return 0;
     }
 
-// SSL/TLS handshake
-#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
-    esp_ssl_debug_print(PSTR("Wait for SSL handshake."), _debug_level, esp_ssl_debug_info, __func__);
-#endif
-
-    if (mRunUntil(BR_SSL_SENDAPP, _handshake_timeout) < 0)
-    {
-#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
-        esp_ssl_debug_print(PSTR("Failed to initlalize the SSL layer."), _debug_level, esp_ssl_debug_error, __func__);
-        mPrintSSLError(br_ssl_engine_last_error(_eng), esp_ssl_debug_error, __func__);
-#endif
-        mFreeSSL();
-        return 0;
-    }
+    return 1;
+}
 
+int BSSL_SSL_Client::mFinishSSL()
+{
 #if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
     esp_ssl_debug_print(PSTR("Connection successful!"), _debug_level, esp_ssl_debug_info, __func__);
 #endif
@@ -1587,6 +1868,7 @@ int BSSL_SSL_Client::mConnectSSL(const char *host)
     _x509_minimal = nullptr;
     _x509_insecure = nullptr;
     _x509_knownkey = nullptr;
+    _x509_pinned = nullptr;
 
     return 1;
 }
@@ -1596,14 +1878,24 @@ bool BSSL_SSL_Client::mConnectionValidate(const char *host, IPAddress ip, uint16
     if (!mIsClientInitialized(true))
         return false;
 
+    // The basic client that was already connected to the same server (e.g. by the resolved address) will be used
     if (_basic_client && _basic_client->connected() &&
-                host
-            ? (strcasecmp(host, _host.c_str()) != 0 || port != _port)
-            : (ip != _ip || port != _port))
+        (host ? (_host.length() > 0 && (strcasecmp(host, _host.c_str()) != 0 || port != _port))
+              : (ip != _ip || port != _port)))
     {
         _basic_client->stop();
     }
 
+    // The connection that will be made by the basic client belongs to this server
+    if (_basic_client && !_basic_client->connected())
+    {
+        if (host)
+            _host = host;
+        else
+            _ip = ip;
+        _port = port;
+    }
+
     return true;
 }
 
@@ -1970,6 +2262,109 @@ void BSSL_SSL_Client::mBSSLX509InsecureInit(bssl::br_x509_insecure_context *ctx,
     ctx->allow_self_signed = _allow_self_signed ? 1 : 0;
 }
 
+void BSSL_SSL_Client::mBSSLX509PinnedInit(bssl::br_x509_pinned_context *ctx, br_x509_minimal_context *inner)
+{
+    static const br_x509_class br_x509_pinned_vtable PROGMEM = {
+        sizeof(bssl::br_x509_pinned_context),
+        bssl::pinned_start_chain,
+        bssl::pinned_start_cert,
+        bssl::pinned_append,
+        bssl::pinned_end_cert,
+        bssl::pinned_end_chain,
+        bssl::pinned_get_pkey};
+
+    memset(ctx, 0, sizeof *ctx);
+    ctx->vtable = &br_x509_pinned_vtable;
+    ctx->inner = &inner->vtable;
+    ctx->pins = _pins.data();
+    ctx->pin_count = _pins.size();
+    ctx->ttl = _pin_ttl;
+    ctx->ignore_time = _x509_ignore_time;
+    // The pinned chain is not accepted when the time is unknown or ignored
+    if (!_x509_ignore_time && _now >= ESP_SSLCLIENT_VALID_TIMESTAMP)
+    {
+        ctx->days = ((uint32_t)_now) / 86400 + 719528;
+        ctx->seconds = ((uint32_t)_now) % 86400;
+    }
+}
+
+void BSSL_SSL_Client::mClearPins()
+{
+    for (size_t i = 0; i < _pins.size(); i++)
+        _pins[i].valid = false;
+}
+
+// Index the CA trust anchors by the SHA-256 of their DN once for all handshakes, x509_minimal
+// then finds the issuer with binary search instead of hashing the DN of every anchor per certificate.
+bool BSSL_SSL_Client::mBuildTAIndex(const br_x509_trust_anchor *ta, size_t count)
+{
+    if (!ta || count < ESP_SSLCLIENT_TA_INDEX_MIN)
+        return false;
+
+    // The anchors were changed or extended since the index was built
+    if (ta != _ta_index_src || count != _ta_index_src_count)
+    {
+        mClearTAIndex();
+
+        _ta_index_entries.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            // The direct trust anchors are only checked by the linear scan
+            if (!(ta[i].flags & BR_X509_TA_CA))
+            {
+                _ta_linear.push_back(ta[i]);
+                continue;
+            }
+            bssl::br_x509_ta_index_entry entry;
+            br_sha256_context sha;
+            br_sha256_init(&sha);
+            br_sha256_update(&sha, ta[i].dn.data, ta[i].dn.len);
+            br_sha256_out(&sha, entry.dn_hash);
+            entry.ta = &ta[i];
+            _ta_index_entries.push_back(entry);
+        }
+
+        std::sort(_ta_index_entries.begin(), _ta_index_entries.end(),
+                  [](const bssl::br_x509_ta_index_entry &a, const bssl::br_x509_ta_index_entry &b)
+                  { return memcmp(a.dn_hash, b.dn_hash, sizeof(a.dn_hash)) < 0; });
+
+        // The anchors with the same DN (e.g. the renewed root keys) can't be found with a single
+        // lookup, they are left to the linear scan
+        size_t n = 0;
+        for (size_t i = 0; i < _ta_index_entries.size();)
+        {
+            size_t j = i + 1;
+            while (j < _ta_index_entries.size() && memcmp(_ta_index_entries[i].dn_hash, _ta_index_entries[j].dn_hash, sizeof(_ta_index_entries[i].dn_hash)) == 0)
+                j++;
+            if (j - i == 1)
+                _ta_index_entries[n++] = _ta_index_entries[i];
+            else
+            {
+                for (size_t k = i; k < j; k++)
+                    _ta_linear.push_back(*_ta_index_entries[k].ta);
+            }
+            i = j;
+        }
+        _ta_index_entries.resize(n);
+
+        _ta_index_src = ta;
+        _ta_index_src_count = count;
+    }
+
+    memset(&_ta_index, 0, sizeof(_ta_index));
+    _ta_index.entries = _ta_index_entries.data();
+    _ta_index.count = _ta_index_entries.size();
+    return true;
+}
+
+void BSSL_SSL_Client::mClearTAIndex()
+{
+    _ta_index_entries.clear();
+    _ta_linear.clear();
+    _ta_index_src = nullptr;
+    _ta_index_src_count = 0;
+}
+
 void BSSL_SSL_Client::mClearAuthenticationSettings()
 {
     _use_insecure = false;
@@ -1977,10 +2372,13 @@ void BSSL_SSL_Client::mClearAuthenticationSettings()
     _use_self_signed = false;
     _knownkey = nullptr;
     _ta = nullptr;
+    _static_ta = nullptr;
+    _static_ta_count = 0;
     if (_esp32_ta)
     {
         delete _esp32_ta;
         _esp32_ta = nullptr;
+        mClearTAIndex();
     }
 }
 
@@ -2011,6 +2409,7 @@ void BSSL_SSL_Client::mClear()
     {
         delete _esp32_ta;
         _esp32_ta = nullptr;
+        mClearTAIndex();
     }
 }
 
@@ -2072,14 +2471,30 @@ bool BSSL_SSL_Client::mInstallClientX509Validator()
 #endif
             return false;
         }
+        const br_x509_trust_anchor *ta = nullptr;
+        size_t ta_count = 0;
         if (_esp32_ta)
         {
-            br_x509_minimal_init(_x509_minimal.get(), &br_sha256_vtable, _esp32_ta->getTrustAnchors(), _esp32_ta->getCount());
+            ta = _esp32_ta->getTrustAnchors();
+            ta_count = _esp32_ta->getCount();
         }
-        else
+        else if (_static_ta)
+        {
+            ta = _static_ta;
+            ta_count = _static_ta_count;
+        }
+        else if (_ta)
         {
-            br_x509_minimal_init(_x509_minimal.get(), &br_sha256_vtable, _ta ? _ta->getTrustAnchors() : nullptr, _ta ? _ta->getCount() : 0);
+            ta = _ta->getTrustAnchors();
+            ta_count = _ta->getCount();
         }
+
+        // Only the anchors that were not indexed are scanned by x509_minimal
+        bool ta_indexed = mBuildTAIndex(ta, ta_count);
+        if (ta_indexed)
+            br_x509_minimal_init(_x509_minimal.get(), &br_sha256_vtable, _ta_linear.data(), _ta_linear.size());
+        else
+            br_x509_minimal_init(_x509_minimal.get(), &br_sha256_vtable, ta, ta_count);
         br_x509_minimal_set_rsa(_x509_minimal.get(), br_ssl_engine_get_rsavrfy(_eng));
 #ifndef BEARSSL_SSL_BASIC
         br_x509_minimal_set_ecdsa(_x509_minimal.get(), br_ssl_engine_get_ec(_eng), br_ssl_engine_get_ecdsa(_eng));
@@ -2101,7 +2516,30 @@ bool BSSL_SSL_Client::mInstallClientX509Validator()
             _certStore->installCertStore(_x509_minimal.get());
         }
 #endif
-        br_ssl_engine_set_x509(_eng, &_x509_minimal->vtable);
+        if (ta_indexed)
+        {
+            // The cert store lookup is chained after the index
+            _ta_index.next_ctx = _x509_minimal->trust_anchor_dynamic_ctx;
+            _ta_index.next = _x509_minimal->trust_anchor_dynamic;
+            _ta_index.next_free = _x509_minimal->trust_anchor_dynamic_free;
+            br_x509_minimal_set_dynamic(_x509_minimal.get(), &_ta_index, bssl::ta_index_find, bssl::ta_index_free);
+        }
+        if (_pin_ttl > 0 || _x509_ignore_time)
+        {
+            // The pinned chain is checked by its fingerprint, other chains are passed to x509_minimal
+            _x509_pinned = std::make_shared<struct bssl::br_x509_pinned_context>();
+            if (!_x509_pinned)
+            {
+#if defined(ESP_SSLCLIENT_ENABLE_DEBUG)
+                esp_ssl_debug_print(PSTR("OOM for _x509_pinned"), _debug_level, esp_ssl_debug_error, __func__);
+#endif
+                return false;
+            }
+            mBSSLX509PinnedInit(_x509_pinned.get(), _x509_minimal.get());
+            br_ssl_engine_set_x509(_eng, &_x509_pinned->vtable);
+        }
+        else
+            br_ssl_engine_set_x509(_eng, &_x509_minimal->vtable);
     }
     return true;
 }
@@ -2113,6 +2551,7 @@ void BSSL_SSL_Client::mFreeSSL()
     _x509_minimal = nullptr;
     _x509_insecure = nullptr;
     _x509_knownkey = nullptr;
+    _x509_pinned = nullptr;
     freeImpl(&_iobuf_in);
     freeImpl(&_iobuf_out);
     // Reset non-allocated ptrs (pointing to bits potentially free'd above)
@@ -2120,6 +2559,7 @@ void BSSL_SSL_Client::mFreeSSL()
     _recvapp_len = 0;
     // This connection is toast
     _handshake_done = false;
+    _handshake_pending = false;
     _timeout = 15000;
     _secure = false;
     _is_connected = false;
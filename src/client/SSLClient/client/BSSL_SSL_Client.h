@@ -116,6 +116,8 @@ public:
 
     size_t write(Stream &stream);
 
+    size_t writev(const esp_ssl_client_segment *segments, size_t count, size_t *records = nullptr);
+
     int peek() override;
 
     size_t peekBytes(uint8_t *buffer, size_t length);
@@ -128,6 +130,10 @@ public:
 
     int connectSSL(const char *host, uint16_t port);
 
+    int connectAsync(const char *host, uint16_t port);
+
+    int pollConnect();
+
     
 
     void stop() override;
@@ -156,8 +162,14 @@ public:
 
     void setTrustAnchors(const X509List *ta);
 
+    void setTrustAnchors(const br_x509_trust_anchor *ta, size_t count);
+
     void setX509Time(time_t now);
 
+    void setX509IgnoreTime(bool ignore);
+
+    void setPinCache(uint32_t ttl);
+
     void setClientRSACert(const X509List *chain, const PrivateKey *sk);
 
     void setClientECCert(const X509List *chain, const PrivateKey *sk, unsigned allowed_usages, unsigned cert_issuer_key_type);
@@ -240,6 +252,12 @@ private:
 
     int mConnectSSL(const char *host = nullptr);
 
+    // Sets up the engine and starts the handshake
+    int mStartSSL(const char *host);
+
+    // Keeps the session and marks the connection as secure after the handshake
+    int mFinishSSL();
+
     bool mConnectionValidate(const char *host, IPAddress ip, uint16_t port);
 
     int mRunUntil(const unsigned target, unsigned long timeout = 0);
@@ -254,6 +272,14 @@ private:
 
     bool mIsSecurePort(uint16_t port);
 
+    void mBSSLX509PinnedInit(bssl::br_x509_pinned_context *ctx, br_x509_minimal_context *inner);
+
+    void mClearPins();
+
+    bool mBuildTAIndex(const br_x509_trust_anchor *ta, size_t count);
+
+    void mClearTAIndex();
+
     void mBSSLX509InsecureInit(bssl::br_x509_insecure_context *ctx, int _use_fingerprint, const uint8_t _fingerprint[20], int _allow_self_signed);
 
     void mClearAuthenticationSettings();
@@ -294,6 +320,13 @@ private:
     std::shared_ptr<br_x509_minimal_context> _x509_minimal;
     std::shared_ptr<struct bssl::br_x509_insecure_context> _x509_insecure;
     std::shared_ptr<br_x509_knownkey_context> _x509_knownkey;
+    std::shared_ptr<struct bssl::br_x509_pinned_context> _x509_pinned;
+
+    // The pins of the validated certificate chains which are kept between connections
+    std::vector<bssl::br_x509_pin> _pins;
+    uint32_t _pin_ttl = 0;
+    // The certificate validity period is not checked
+    bool _x509_ignore_time = false;
 
     unsigned char *_iobuf_in = nullptr;
     unsigned char *_iobuf_out = nullptr;
@@ -302,6 +335,15 @@ private:
 
     time_t _now = 0;
     const X509List *_ta = nullptr;
+    // The trust anchors that were created at compile time
+    const br_x509_trust_anchor *_static_ta = nullptr;
+    size_t _static_ta_count = 0;
+    // The CA trust anchors indexed by their DN hash and the anchors that are left to the linear scan
+    std::vector<bssl::br_x509_ta_index_entry> _ta_index_entries;
+    std::vector<br_x509_trust_anchor> _ta_linear;
+    const br_x509_trust_anchor *_ta_index_src = nullptr;
+    size_t _ta_index_src_count = 0;
+    bssl::br_x509_ta_index _ta_index;
 #if defined(ESP_SSL_FS_SUPPORTED)
     CertStoreBase *_certStore = 0;
 #endif
@@ -335,6 +377,9 @@ private:
     PrivateKey *_esp32_sk = nullptr;
 
     bool _handshake_done = false;
+    // The handshake that was started by connectAsync and is processed by pollConnect
+    bool _handshake_pending = false;
+    unsigned long _handshake_millis = 0;
     bool _oom_err = false;
     unsigned char *_recvapp_buf = nullptr;
     size_t _recvapp_len;
@@ -129,6 +129,19 @@ int BSSL_TCP_Client::connect(const char *host, uint16_t port, int32_t timeout)
     return _ssl_client.connect(host, port);
 }
 
+int BSSL_TCP_Client::connectAsync(const char *host, uint16_t port)
+{
+    _host = host;
+    _port = port;
+
+    return _ssl_client.connectAsync(host, port);
+}
+
+int BSSL_TCP_Client::pollConnect()
+{
+    return _ssl_client.pollConnect();
+}
+
 uint8_t BSSL_TCP_Client::connected()
 {
     return _ssl_client.connected();
@@ -232,6 +245,13 @@ size_t BSSL_TCP_Client::write(const char *buf) { return write((const uint8_t *)b
 
 size_t BSSL_TCP_Client::write(Stream &stream) { return _ssl_client.write(stream); }
 
+size_t BSSL_TCP_Client::writev(const esp_ssl_client_segment *segments, size_t count, size_t *records)
+{
+    if (!_ssl_client.connected())
+        return 0;
+    return _ssl_client.writev(segments, count, records);
+}
+
 int BSSL_TCP_Client::peek()
 {
     return _ssl_client.peek();
@@ -323,11 +343,26 @@ void BSSL_TCP_Client::setTrustAnchors(const X509List *ta)
     _ssl_client.setTrustAnchors(ta);
 }
 
+void BSSL_TCP_Client::setTrustAnchors(const br_x509_trust_anchor *ta, size_t count)
+{
+    _ssl_client.setTrustAnchors(ta, count);
+}
+
 void BSSL_TCP_Client::setX509Time(time_t now)
 {
     _ssl_client.setX509Time(now);
 }
 
+void BSSL_TCP_Client::setX509IgnoreTime(bool ignore)
+{
+    _ssl_client.setX509IgnoreTime(ignore);
+}
+
+void BSSL_TCP_Client::setPinCache(uint32_t ttl)
+{
+    _ssl_client.setPinCache(ttl);
+}
+
 void BSSL_TCP_Client::setClientRSACert(const X509List *cert, const PrivateKey *sk)
 {
     _ssl_client.setClientRSACert(cert, sk);
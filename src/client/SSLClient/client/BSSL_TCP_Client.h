@@ -126,6 +126,23 @@ public:
      */
     int connect(const char *host, uint16_t port, int32_t timeout);
 
+    /**
+     * Connect to server and start the SSL handshake without waiting for it.
+     * The handshake should be processed with pollConnect until it was done.
+     * @param host The server host name.
+     * @param port The server port to connect.
+     * @return 1 for success or 0 for error.
+     * @note The TCP connection is made in this call, it's limited by the TCP timeout.
+     */
+    int connectAsync(const char *host, uint16_t port);
+
+    /**
+     * Process the SSL handshake with the received data without waiting for the server.
+     * @return 1 for connected, 0 for the handshake in progress or -1 for error.
+     * @note The certificate validation and the key exchange of the received records are processed in this call.
+     */
+    int pollConnect();
+
     /**
      * Get TCP connection status.
      * @return 1 for connected or 0 for not connected.
@@ -137,6 +154,7 @@ public:
      * @param host The server host name.
      * @param port The server port to connect.
      * The Client connection will be closed when the provided host or port is not match with that of last connection.
+     * When the Client is not connected, its next connection is taken as the connection of these host and port.
      */
     void validate(const char *host, uint16_t port);
 
@@ -145,6 +163,7 @@ public:
      * @param ip The server IP to connect.
      * @param port The server port to connect.
      * The Client connection will be closed when the provided IP or port is not match with that of last connection.
+     * When the Client is not connected, its next connection is taken as the connection of these IP and port.
      */
     void validate(IPAddress ip, uint16_t port);
 
@@ -259,6 +278,17 @@ public:
      */
     size_t write(Stream &stream);
 
+    /**
+     * The TCP data gather write function.
+     * @param segments The data segments to write, the segment data can be in flash (PROGMEM).
+     * @param count The number of segments.
+     * @param records The optional number of TLS records that were sent.
+     * @return The size of data that was successfully written or 0 for error.
+     * @note The segments are copied into the TLS records directly, the record is sent when it is full
+     * or after the last segment.
+     */
+    size_t writev(const esp_ssl_client_segment *segments, size_t count, size_t *records = nullptr);
+
     /**
      * Read one byte from Stream with time out.
      * @return The byte of data that was successfully read or -1 for timed out.
@@ -348,8 +378,30 @@ public:
 
     void setTrustAnchors(const X509List *ta);
 
+    /**
+     * Set the trust anchors that were created at compile time.
+     * @param ta The trust anchors which should be kept valid while it is used.
+     * @param count The number of trust anchors.
+     */
+    void setTrustAnchors(const br_x509_trust_anchor *ta, size_t count);
+
     void setX509Time(time_t now);
 
+    /**
+     * Verify the certificate chain by the trust anchors and its signatures without checking its validity period.
+     * It's used when the time is unknown e.g. to get the time from the verified server, the chain is not pinned.
+     * @param ignore The ignore option.
+     */
+    void setX509IgnoreTime(bool ignore);
+
+    /**
+     * Keep the pins of the validated certificate chains.
+     * The same server certificate from the same server will be accepted by its fingerprint without verifying
+     * the chain signatures until the pin was expired, the changed certificate is fully validated in the same handshake.
+     * @param ttl The pin lifetime in seconds, 0 to disable.
+     */
+    void setPinCache(uint32_t ttl);
+
     void setClientRSACert(const X509List *cert, const PrivateKey *sk);
 
     void setClientECCert(const X509List *cert, const PrivateKey *sk, unsigned allowed_usages, unsigned cert_issuer_key_type);
@@ -1026,8 +1026,10 @@ public:
 
         size_t slen = length();
 
-        if (n > strlen(cstr))
-            n = strlen(cstr);
+        // the data is not required to be null terminated
+        const char *end = (const char *)memchr(cstr, 0, n);
+        if (end)
+            n = end - cstr;
 
         if (_reserve(slen + n, false))
         {